@@ -0,0 +1,25 @@
+#version 330
+
+// The scene depth target
+uniform sampler2D depth_tex;
+// The sizes (in pixels) of the depth target and of the Hi-Z base that we are drawing into
+uniform vec2 source_size;
+uniform vec2 target_size;
+
+out vec4 frag_color;
+
+void main(){
+    // Find the range of depth texels covered by this texel (rounded outwards so that no depth texel is missed)
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    ivec2 first = ivec2(floor(vec2(texel) * source_size / target_size));
+    ivec2 last = min(ivec2(ceil(vec2(texel + 1) * source_size / target_size)), ivec2(source_size)) - 1;
+
+    // The base keeps the farthest depth so that an object behind it is guaranteed to be behind every covered pixel
+    float farthest = 0.0;
+    for(int y = first.y; y <= last.y; y++){
+        for(int x = first.x; x <= last.x; x++){
+            farthest = max(farthest, texelFetch(depth_tex, ivec2(x, y), 0).r);
+        }
+    }
+    frag_color = vec4(farthest);
+}
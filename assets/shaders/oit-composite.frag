@@ -0,0 +1,21 @@
+#version 330
+
+// The targets written by the transparent objects in the weighted blended OIT pass
+// accum_tex.rgb holds the sum of the weighted premultiplied colors and accum_tex.a holds the revealage (the product of (1 - alpha))
+// weight_tex.r holds the sum of the weighted alphas
+uniform sampler2D accum_tex;
+uniform sampler2D weight_tex;
+
+out vec4 frag_color;
+
+void main(){
+    // The targets have the same size as the scene, so we can fetch the texels directly
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    vec4 accum = texelFetch(accum_tex, pixel, 0);
+    float revealage = accum.a;
+    // No transparent object covers this pixel
+    if(revealage >= 1.0) discard;
+    float weight = texelFetch(weight_tex, pixel, 0).r;
+    // The average color is blended over the scene using the revealage (GL_ONE_MINUS_SRC_ALPHA, GL_SRC_ALPHA)
+    frag_color = vec4(accum.rgb / max(weight, 1e-5), revealage);
+}
@@ -0,0 +1,22 @@
+// Included by the fragment shaders that can be drawn in the weighted blended OIT pass of the renderer
+// The renderer sends a transparent object to that pass only if all the shaders it is drawn with include this file.
+
+layout(location = 0) out vec4 frag_color;
+// Only written in the weighted blended OIT pass of the renderer (see "assets/shaders/oit-composite.frag")
+layout(location = 1) out vec4 oit_weight;
+
+// Set by the renderer while drawing transparent objects in its weighted blended OIT pass
+uniform bool oit;
+
+// Writes the color either directly or as a weighted contribution to the OIT accumulation targets
+// The weight favors fragments that are closer to the camera and more opaque (McGuire & Bavoil 2013)
+void write_color(vec4 color){
+    if(oit){
+        float weight = clamp(pow(min(1.0, color.a * 10.0) + 0.01, 3.0) * 1e8 * pow(1.0 - gl_FragCoord.z * 0.9, 3.0), 1e-2, 3e3);
+        frag_color = vec4(color.rgb * color.a * weight, color.a);
+        oit_weight = vec4(color.a * weight);
+    } else {
+        frag_color = color;
+        oit_weight = vec4(0.0);
+    }
+}
@@ -0,0 +1,62 @@
+#version 330
+
+// The texture holding the scene pixels
+uniform sampler2D tex;
+// The size of a single texel of "tex" (1 / texture size)
+uniform vec2 texel_size;
+
+// Read "assets/shaders/fullscreen.vert" to know what "tex_coord" holds;
+in vec2 tex_coord;
+
+out vec4 frag_color;
+
+// FXAA (Fast Approximate Anti-Aliasing) finds edges using the luminance contrast between neighbouring pixels
+// then blurs along the edge direction. It is much cheaper than supersampling since it is a single fullscreen pass.
+
+#define FXAA_EDGE_THRESHOLD     (1.0/8.0)
+#define FXAA_EDGE_THRESHOLD_MIN (1.0/32.0)
+#define FXAA_REDUCE_MUL         (1.0/8.0)
+#define FXAA_REDUCE_MIN         (1.0/128.0)
+#define FXAA_SPAN_MAX           8.0
+
+float luma(vec3 color){
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+void main(){
+    vec4 center = texture(tex, tex_coord);
+    float lumaM  = luma(center.rgb);
+    float lumaNW = luma(texture(tex, tex_coord + vec2(-1.0, -1.0) * texel_size).rgb);
+    float lumaNE = luma(texture(tex, tex_coord + vec2( 1.0, -1.0) * texel_size).rgb);
+    float lumaSW = luma(texture(tex, tex_coord + vec2(-1.0,  1.0) * texel_size).rgb);
+    float lumaSE = luma(texture(tex, tex_coord + vec2( 1.0,  1.0) * texel_size).rgb);
+
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // Skip the pixels that are not on an edge (which are most of the screen)
+    if(lumaMax - lumaMin < max(FXAA_EDGE_THRESHOLD_MIN, lumaMax * FXAA_EDGE_THRESHOLD)){
+        frag_color = center;
+        return;
+    }
+
+    // The blur direction is perpendicular to the luminance gradient
+    vec2 dir = vec2(
+        -((lumaNW + lumaNE) - (lumaSW + lumaSE)),
+         ((lumaNW + lumaSW) - (lumaNE + lumaSE))
+    );
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE) * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    float rcpDirMin = 1.0 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX)) * texel_size;
+
+    vec3 rgbA = 0.5 * (
+        texture(tex, tex_coord + dir * (1.0/3.0 - 0.5)).rgb +
+        texture(tex, tex_coord + dir * (2.0/3.0 - 0.5)).rgb);
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (
+        texture(tex, tex_coord + dir * -0.5).rgb +
+        texture(tex, tex_coord + dir *  0.5).rgb);
+
+    // If the wider blur sampled across another edge, fall back to the narrower one
+    float lumaB = luma(rgbB);
+    frag_color = vec4((lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB, center.a);
+}
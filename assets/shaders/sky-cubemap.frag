@@ -0,0 +1,17 @@
+#version 330
+
+// The inverse of the view projection matrix after removing the camera translation
+uniform mat4 inverse_view_projection;
+// A cube map sky texture
+uniform samplerCube tex;
+
+in vec2 ndc;
+
+out vec4 frag_color;
+
+void main(){
+    // Unproject the pixel to the far plane. Since the view has no translation, the camera is at the origin
+    // so the unprojected point is also the direction of the view ray
+    vec4 far_point = inverse_view_projection * vec4(ndc, 1.0, 1.0);
+    frag_color = texture(tex, far_point.xyz / far_point.w);
+}
@@ -0,0 +1,25 @@
+#version 330
+
+// The inverse of the view projection matrix after removing the camera translation
+uniform mat4 inverse_view_projection;
+// An equirectangular sky texture
+uniform sampler2D tex;
+
+in vec2 ndc;
+
+out vec4 frag_color;
+
+#define PI 3.14159265359
+
+void main(){
+    // Unproject the pixel to the far plane. Since the view has no translation, the camera is at the origin
+    // so the unprojected point is also the direction of the view ray
+    vec4 far_point = inverse_view_projection * vec4(ndc, 1.0, 1.0);
+    vec3 direction = normalize(far_point.xyz / far_point.w);
+    // Map the direction to the equirectangular texture (u follows the yaw and v follows the pitch)
+    vec2 uv = vec2(
+        atan(direction.z, direction.x) / (2.0 * PI),
+        asin(clamp(direction.y, -1.0, 1.0)) / PI + 0.5
+    );
+    frag_color = texture(tex, vec2(fract(uv.x), uv.y));
+}
@@ -0,0 +1,19 @@
+#version 330
+
+// The NDC position of the pixel which is used to reconstruct its view ray
+out vec2 ndc;
+
+void main(){
+
+    // These positions define a fullscreen triangle (see "assets/shaders/fullscreen.vert")
+    vec2 positions[] = vec2[](
+        vec2(-1.0, -1.0),
+        vec2( 3.0, -1.0),
+        vec2(-1.0,  3.0)
+    );
+
+    // Since z == w, the triangle lies on the far plane (depth = 1)
+    // so it only passes the depth test (GL_LEQUAL) where no object was drawn
+    gl_Position = vec4(positions[gl_VertexID], 1.0, 1.0);
+    ndc = positions[gl_VertexID];
+}
@@ -5,7 +5,7 @@ in Varyings {
     vec2 tex_coord;
 } fs_in;
 
-out vec4 frag_color;
+#include "oit.glsl"
 
 uniform vec4 tint;
 uniform sampler2D tex;
@@ -20,6 +20,6 @@ void main(){
     //frag_color = final_color;
     //frag_color = texture(tex, fs_in.tex_coord) * tint * fs_in.color;
     vec2 uv = fract(fs_in.tex_coord);
-    frag_color = texture(tex, uv) * tint * fs_in.color;
+    write_color(texture(tex, uv) * tint * fs_in.color);
 
 }
\ No newline at end of file
@@ -4,7 +4,7 @@ in Varyings {
     vec4 color;
 } fs_in;
 
-out vec4 frag_color;
+#include "oit.glsl"
 
 uniform vec4 tint;
 
@@ -12,6 +12,6 @@ void main(){
     //TODO: (Req 7) Modify the following line to compute the fragment color
     // by multiplying the tint with the vertex color
     vec4 tinted_color = tint * fs_in.color;
-    frag_color = tinted_color;
+    write_color(tinted_color);
     //frag_color = vec4(1.0);
 }
\ No newline at end of file
@@ -120,6 +120,7 @@ void our::Application::configureOpenGL() {
     glfwWindowHint(GLFW_RESIZABLE, GLFW_FALSE);
 
     //Set Number of sample used in MSAA (0 = Disabled)
+    //The default framebuffer doesn't need MSAA since the forward renderer resolves its own multisampled framebuffer (see "msaa" in the renderer config)
     glfwWindowHint(GLFW_SAMPLES, 0);
 
     //Enable Double Buffering
@@ -7,6 +7,7 @@
 #include "mesh/mesh.hpp"
 #include "mesh/mesh-utils.hpp"
 #include "material/material.hpp"
+#include "ecs/prefab.hpp"
 #include "deserialize-utils.hpp"
 
 namespace our {
@@ -63,12 +64,33 @@ namespace our {
     // This will load all the meshes defined in "data"
     // data must be in the form:
     //    { mesh_name : "path/to/3d-model-file", ... }
+    // or, to add levels of detail to a mesh:
+    //    { mesh_name : { "path": "path/to/3d-model-file", "lods": [ level, ... ] }, ... }
+    // Where the levels are ordered from the finest to the coarsest and each level is an object where:
+    //      "screenSize" is the projected size (relative to the screen height) below which the level is used
+    //      "path" is the path to the 3d model file of the level, or
+    //      "cluster" is the grid resolution used to generate the level by simplifying the mesh (see "mesh_utils::simplify")
     template<>
     void AssetLoader<Mesh>::deserialize(const nlohmann::json& data) {
         if(data.is_object()){
             for(auto& [name, desc] : data.items()){
-                std::string path = desc.get<std::string>();
-                assets[name] = mesh_utils::loadOBJ(path);
+                if(desc.is_string()){
+                    assets[name] = mesh_utils::loadOBJ(desc.get<std::string>());
+                    continue;
+                }
+                Mesh* mesh = mesh_utils::loadOBJ(desc.value("path", ""));
+                if(mesh && desc.contains("lods")){
+                    for(auto& lodDesc : desc["lods"]){
+                        Mesh* lodMesh = nullptr;
+                        if(lodDesc.contains("path")){
+                            lodMesh = mesh_utils::loadOBJ(lodDesc["path"].get<std::string>());
+                        } else if(lodDesc.contains("cluster")){
+                            lodMesh = mesh_utils::simplify(*mesh, lodDesc["cluster"].get<int>());
+                        }
+                        if(lodMesh) mesh->lods.push_back({ lodMesh, lodDesc.value("screenSize", 0.0f) });
+                    }
+                }
+                assets[name] = mesh;
             }
         }
     };
@@ -97,6 +119,21 @@ namespace our {
         }
     };
 
+    // This will load all the prefabs defined in "data"
+    // data must be in the form:
+    //    { prefab_name : entity_description, ... }
+    // where the entity description has the same form as the entities of the world (including "components" and "children")
+    template<>
+    void AssetLoader<Prefab>::deserialize(const nlohmann::json& data) {
+        if(data.is_object()){
+            for(auto& [name, desc] : data.items()){
+                auto prefab = new Prefab();
+                prefab->deserialize(desc);
+                assets[name] = prefab;
+            }
+        }
+    };
+
     void deserializeAllAssets(const nlohmann::json& assetData){
         if(!assetData.is_object()) return;
         if(assetData.contains("shaders"))
@@ -109,9 +146,13 @@ namespace our {
             AssetLoader<Mesh>::deserialize(assetData["meshes"]);
         if(assetData.contains("materials"))
             AssetLoader<Material>::deserialize(assetData["materials"]);
+        // The prefabs are loaded last since their components refer to the other assets
+        if(assetData.contains("prefabs"))
+            AssetLoader<Prefab>::deserialize(assetData["prefabs"]);
     }
 
     void clearAllAssets(){
+        AssetLoader<Prefab>::clear();
         AssetLoader<ShaderProgram>::clear();
         AssetLoader<Texture2D>::clear();
         AssetLoader<Sampler>::clear();
@@ -1,30 +1,96 @@
 #include "bullet-collider.hpp"
-#include "../ecs/entity.hpp"
+#include "../ecs/component-registry.hpp"
 #include "../asset-loader.hpp"
+#include "../systems/collision-shape-cache.hpp"
+#include "../systems/bvh-cache.hpp"
+#include "../systems/convex-decomposition.hpp"
+#include "../mesh/mesh-utils.hpp"
+#include <glm/gtc/epsilon.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/quaternion.hpp>
+#include <cstddef>
 #include <iostream>
 
 namespace our {
 
+    OUR_REGISTER_COMPONENT(BulletColliderComponent)
+
+    namespace {
+        // The first six groups are Bullet's own filter groups, the rest are free for the game
+        const std::pair<const char*, int> COLLISION_GROUPS[] = {
+            {"default", btBroadphaseProxy::DefaultFilter},
+            {"static", btBroadphaseProxy::StaticFilter},
+            {"kinematic", btBroadphaseProxy::KinematicFilter},
+            {"debris", btBroadphaseProxy::DebrisFilter},
+            {"trigger", btBroadphaseProxy::SensorTrigger},
+            {"character", btBroadphaseProxy::CharacterFilter},
+            {"player", 1 << 6},
+            {"zombie", 1 << 7},
+            {"prop", 1 << 8},
+        };
+
+        int parseCollisionGroups(const nlohmann::json& data) {
+            if (data.is_number_integer()) return data.get<int>();
+            if (data.is_string()) {
+                std::string name = data.get<std::string>();
+                if (name == "all") return btBroadphaseProxy::AllFilter;
+                int bit = BulletColliderComponent::getCollisionGroupBit(name);
+                if (bit == 0) std::cerr << "Unknown collision group: " << name << std::endl;
+                return bit;
+            }
+            int groups = 0;
+            if (data.is_array()) {
+                for (auto& item : data) groups |= parseCollisionGroups(item);
+            }
+            return groups;
+        }
+    }
+
+    int BulletColliderComponent::getCollisionGroupBit(const std::string& name) {
+        for (auto& [groupName, bit] : COLLISION_GROUPS) {
+            if (name == groupName) return bit;
+        }
+        return 0;
+    }
+
+    int BulletColliderComponent::getCollisionGroup() const {
+        if (collisionGroup != 0) return collisionGroup;
+        if (isTrigger) return btBroadphaseProxy::SensorTrigger;
+        return mass > 0.0f ? btBroadphaseProxy::DefaultFilter : btBroadphaseProxy::StaticFilter;
+    }
+
+    int BulletColliderComponent::getCollisionMask() const {
+        if (collisionMask != 0) return collisionMask;
+        // Like Bullet's defaults, the static colliders don't look for each other
+        if (mass > 0.0f) return btBroadphaseProxy::AllFilter;
+        return btBroadphaseProxy::AllFilter ^ btBroadphaseProxy::StaticFilter;
+    }
+
     BulletColliderComponent::BulletColliderComponent() 
-        : collisionShape(nullptr), rigidBody(nullptr), motionState(nullptr),
+        : rigidBody(nullptr), motionState(nullptr),
           shapeType(CollisionShape::BOX), size(1.0f, 1.0f, 1.0f),
           mass(0.0f), friction(0.5f), restitution(0.0f), isTrigger(false),
+          reportContacts(false), collisionGroup(0), collisionMask(0),
           centerOffset(0.0f), mesh(nullptr) {
     }
 
+    BulletColliderComponent::BulletColliderComponent(const BulletColliderComponent& other)
+        : Component(other), rigidBody(nullptr), motionState(nullptr),
+          shapeType(other.shapeType), size(other.size),
+          mass(other.mass), friction(other.friction), restitution(other.restitution), isTrigger(other.isTrigger),
+          reportContacts(other.reportContacts), collisionGroup(other.collisionGroup), collisionMask(other.collisionMask),
+          centerOffset(other.centerOffset), mesh(other.mesh) {
+    }
+
     BulletColliderComponent::~BulletColliderComponent() {
         // Clean up Bullet objects in reverse order of creation
+        // The shape is released after the body (it is deleted when the last collider sharing it is destroyed)
         if (rigidBody) {
             if (rigidBody->getMotionState()) {
                 delete rigidBody->getMotionState();
             }
             delete rigidBody;
         }
-        if (collisionShape) {
-            delete collisionShape;
-        }
     }
 
     void BulletColliderComponent::deserialize(const nlohmann::json& data) {
@@ -38,6 +104,7 @@ namespace our {
         else if (shapeTypeStr == "cylinder") shapeType = CollisionShape::CYLINDER;
         else if (shapeTypeStr == "mesh") shapeType = CollisionShape::MESH;
         else if (shapeTypeStr == "convex") shapeType = CollisionShape::CONVEX_HULL;
+        else if (shapeTypeStr == "decomposed") shapeType = CollisionShape::DECOMPOSED;
 
         // Read size
         if (data.contains("size")) {
@@ -52,6 +119,11 @@ namespace our {
         friction = data.value("friction", 0.5f);
         restitution = data.value("restitution", 0.0f);
         isTrigger = data.value("isTrigger", false);
+        reportContacts = data.value("events", false);
+
+        // Read the collision group and mask (a group name, a bit value or an array of them)
+        if (data.contains("group")) collisionGroup = parseCollisionGroups(data["group"]);
+        if (data.contains("mask")) collisionMask = parseCollisionGroups(data["mask"]);
         
         // Read center offset
         if (data.contains("centerOffset")) {
@@ -68,163 +140,238 @@ namespace our {
         }
     }
 
-    btCollisionShape* BulletColliderComponent::createShape() {
-        btCollisionShape* shape = nullptr;
+    CollisionShapeKey BulletColliderComponent::getShapeKey() const {
+        CollisionShapeKey key;
+        key.type = shapeType;
+        switch (shapeType) {
+            case CollisionShape::MESH:
+                // The entity scale is applied by the shape (the position and rotation are applied by the body)
+                key.mesh = mesh;
+                key.size = getWorldScale();
+                break;
+            case CollisionShape::CONVEX_HULL:
+            case CollisionShape::DECOMPOSED:
+                key.mesh = mesh;
+                key.size = getWorldScale();
+                break;
+            default:
+                key.size = size;
+                break;
+        }
+        return key;
+    }
+
+    std::shared_ptr<btCollisionShape> BulletColliderComponent::createShape(CollisionShapeCache* shapeCache) {
+        std::shared_ptr<btCollisionShape> shape;
 
         switch (shapeType) {
             case CollisionShape::BOX:
-                shape = new btBoxShape(btVector3(size.x * 0.5f, size.y * 0.5f, size.z * 0.5f));
+                shape.reset(new btBoxShape(btVector3(size.x * 0.5f, size.y * 0.5f, size.z * 0.5f)));
                 break;
 
             case CollisionShape::SPHERE:
-                shape = new btSphereShape(size.x); // Use x component as radius
+                shape.reset(new btSphereShape(size.x)); // Use x component as radius
                 break;
 
             case CollisionShape::CAPSULE:
-                shape = new btCapsuleShape(size.x, size.y); // radius, height
+                shape.reset(new btCapsuleShape(size.x, size.y)); // radius, height
                 break;
 
             case CollisionShape::CYLINDER:
-                shape = new btCylinderShape(btVector3(size.x, size.y * 0.5f, size.z));
+                shape.reset(new btCylinderShape(btVector3(size.x, size.y * 0.5f, size.z)));
                 break;
 
             case CollisionShape::MESH:
                 // For static mesh collisions (triangle mesh - perfect for buildings)
-                if (mesh && !mesh->vertices.empty()) {
-                    btTriangleMesh* triMesh = new btTriangleMesh();
-                    int triangleCount = 0;
-                    
-                    // Get entity transform to apply to mesh vertices
-                    glm::mat4 transform = getOwner()->getLocalToWorldMatrix();
-                    
-                    // If mesh has direct elements, use them
-                    if (!mesh->elements.empty()) {
-                        for (size_t i = 0; i + 2 < mesh->elements.size(); i += 3) {
-                            unsigned int idx0 = mesh->elements[i];
-                            unsigned int idx1 = mesh->elements[i + 1];
-                            unsigned int idx2 = mesh->elements[i + 2];
-                            
-                            if (idx0 < mesh->vertices.size() && 
-                                idx1 < mesh->vertices.size() && 
-                                idx2 < mesh->vertices.size()) {
-                                
-                                // Apply entity transform to vertices
-                                glm::vec4 v0 = transform * glm::vec4(mesh->vertices[idx0].position, 1.0f);
-                                glm::vec4 v1 = transform * glm::vec4(mesh->vertices[idx1].position, 1.0f);
-                                glm::vec4 v2 = transform * glm::vec4(mesh->vertices[idx2].position, 1.0f);
-                                
-                                triMesh->addTriangle(
-                                    btVector3(v0.x, v0.y, v0.z),
-                                    btVector3(v1.x, v1.y, v1.z),
-                                    btVector3(v2.x, v2.y, v2.z)
-                                );
-                                triangleCount++;
-                            }
-                        }
-                    }
-                    // Otherwise, iterate through submeshes
-                    else if (!mesh->submeshes.empty()) {
-                        // Get EBO data from GPU
-                        GLuint ebo = mesh->getEBO();
-                        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-                        
-                        GLint eboSize = 0;
-                        glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &eboSize);
-                        int elementCount = eboSize / sizeof(unsigned int);
-                        
-                        std::vector<unsigned int> indices(elementCount);
-                        glGetBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, eboSize, indices.data());
-                        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-                        
-                        // Add triangles from all submeshes
-                        for (const auto& submesh : mesh->submeshes) {
-                            for (GLuint i = submesh.offset; i < submesh.offset + submesh.count - 2; i += 3) {
-                                if (i + 2 < indices.size()) {
-                                    unsigned int idx0 = indices[i];
-                                    unsigned int idx1 = indices[i + 1];
-                                    unsigned int idx2 = indices[i + 2];
-                                    
-                                    if (idx0 < mesh->vertices.size() && 
-                                        idx1 < mesh->vertices.size() && 
-                                        idx2 < mesh->vertices.size()) {
-                                        
-                                        // Apply entity transform to vertices
-                                        glm::vec4 v0 = transform * glm::vec4(mesh->vertices[idx0].position, 1.0f);
-                                        glm::vec4 v1 = transform * glm::vec4(mesh->vertices[idx1].position, 1.0f);
-                                        glm::vec4 v2 = transform * glm::vec4(mesh->vertices[idx2].position, 1.0f);
-                                        
-                                        triMesh->addTriangle(
-                                            btVector3(v0.x, v0.y, v0.z),
-                                            btVector3(v1.x, v1.y, v1.z),
-                                            btVector3(v2.x, v2.y, v2.z)
-                                        );
-                                        triangleCount++;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                    
-                    std::cout << "BulletCollider: Created mesh collider with " << triangleCount << " triangles from " 
-                              << mesh->vertices.size() << " vertices (" << mesh->submeshes.size() << " submeshes)" << std::endl;
-                    
-                    if (triangleCount > 0) {
-                        // Use BVH for fast collision queries
-                        shape = new btBvhTriangleMeshShape(triMesh, true);
-                    } else {
-                        delete triMesh;
-                        shape = new btBoxShape(btVector3(10.0f, 10.0f, 10.0f)); // Large fallback
-                    }
-                } else {
-                    std::cout << "BulletCollider: Mesh collider fallback - mesh is " 
-                              << (mesh ? "valid" : "null") << ", vertices: " 
-                              << (mesh ? mesh->vertices.size() : 0) << std::endl;
-                    shape = new btBoxShape(btVector3(10.0f, 10.0f, 10.0f)); // Fallback
-                }
+                shape = createMeshShape(shapeCache);
                 break;
 
             case CollisionShape::CONVEX_HULL:
                 // For dynamic convex collisions
-                if (mesh) {
-                    btConvexHullShape* convexShape = new btConvexHullShape();
-                    // Note: You'd need to add points from your mesh to convexShape
-                    // using convexShape->addPoint()
-                    shape = convexShape;
-                } else {
-                    shape = new btBoxShape(btVector3(0.5f, 0.5f, 0.5f)); // Fallback
-                }
+                shape = createConvexHullShape(shapeCache);
+                break;
+
+            case CollisionShape::DECOMPOSED:
+                // For dynamic concave collisions (a compound of convex parts)
+                shape = createDecomposedShape(shapeCache);
                 break;
         }
 
         return shape;
     }
 
-    void BulletColliderComponent::initialize(btDiscreteDynamicsWorld* world) {
+    std::shared_ptr<btCollisionShape> BulletColliderComponent::createTriangleMeshShape(const Mesh* mesh) {
+        if (!mesh || mesh->vertices.empty() || mesh->elements.size() < 3) return nullptr;
+        // Bullet doesn't check the indices, so a broken mesh is rejected here instead of crashing in the narrow phase
+        for (unsigned int index : mesh->elements) {
+            if (index >= mesh->vertices.size()) return nullptr;
+        }
+
+        // Bullet reads the positions and the indices directly from the CPU copy of the mesh (nothing is copied)
+        btIndexedMesh part;
+        part.m_numTriangles = static_cast<int>(mesh->elements.size() / 3);
+        part.m_triangleIndexBase = reinterpret_cast<const unsigned char*>(mesh->elements.data());
+        part.m_triangleIndexStride = 3 * sizeof(unsigned int);
+        part.m_numVertices = static_cast<int>(mesh->vertices.size());
+        part.m_vertexBase = reinterpret_cast<const unsigned char*>(mesh->vertices.data()) + offsetof(Vertex, position);
+        part.m_vertexStride = sizeof(Vertex);
+        part.m_indexType = PHY_INTEGER;
+        part.m_vertexType = PHY_FLOAT;
+        btTriangleIndexVertexArray* meshInterface = new btTriangleIndexVertexArray();
+        meshInterface->addIndexedMesh(part, PHY_INTEGER);
+
+        // The BVH cache is keyed by the hash of the vertex positions and the indices
+        std::uint64_t contentHash = bvh_cache::hashBytes(mesh->elements.data(), mesh->elements.size() * sizeof(unsigned int));
+        for (const auto& vertex : mesh->vertices) {
+            contentHash = bvh_cache::hashBytes(&vertex.position, sizeof(vertex.position), contentHash);
+        }
+
+        // Use a quantized BVH for fast collision queries
+        // Building it takes seconds for big meshes, so it is loaded from the cache if the same mesh was used before
+        void* bvhBuffer = nullptr;
+        btOptimizedBvh* cachedBvh = bvh_cache::load(contentHash, part.m_numTriangles, bvhBuffer);
+        btBvhTriangleMeshShape* bvhShape = new btBvhTriangleMeshShape(meshInterface, true, cachedBvh == nullptr);
+        if (cachedBvh) {
+            bvhShape->setOptimizedBvh(cachedBvh);
+        } else {
+            bvh_cache::save(contentHash, part.m_numTriangles, bvhShape->getOptimizedBvh());
+        }
+
+        std::cout << "BulletCollider: Created mesh collider with " << part.m_numTriangles << " triangles from "
+                  << mesh->vertices.size() << " vertices (" << mesh->submeshes.size() << " submeshes"
+                  << (cachedBvh ? ", cached BVH" : "") << ")" << std::endl;
+
+        // The shape doesn't own its mesh interface nor a cached BVH, so they are deleted with it
+        return std::shared_ptr<btCollisionShape>(bvhShape, [meshInterface, bvhBuffer](btCollisionShape* meshShape) {
+            delete meshShape;
+            delete meshInterface;
+            if (bvhBuffer) btAlignedFree(bvhBuffer);
+        });
+    }
+
+    std::shared_ptr<btCollisionShape> BulletColliderComponent::createMeshShape(CollisionShapeCache* shapeCache) {
+        // The triangles and their BVH are shared by all the colliders of the same mesh
+        CollisionShapeKey meshKey;
+        meshKey.type = CollisionShape::MESH;
+        meshKey.size = glm::vec3(1.0f);
+        meshKey.mesh = mesh;
+        auto create = [this]() { return createTriangleMeshShape(mesh); };
+        std::shared_ptr<btCollisionShape> meshShape = shapeCache ? shapeCache->get(meshKey, create) : create();
+        if (!meshShape) {
+            std::cout << "BulletCollider: Mesh collider fallback - mesh is "
+                      << (mesh ? "valid" : "null") << ", vertices: "
+                      << (mesh ? mesh->vertices.size() : 0) << std::endl;
+            return std::make_shared<btBoxShape>(btVector3(10.0f, 10.0f, 10.0f)); // Fallback
+        }
+
+        // The entity scale is applied by a scaled shape that refers to the shared one (and keeps it alive)
+        glm::vec3 scale = getWorldScale();
+        if (glm::all(glm::epsilonEqual(scale, glm::vec3(1.0f), 1e-5f))) return meshShape;
+        auto* bvhShape = static_cast<btBvhTriangleMeshShape*>(meshShape.get());
+        return std::shared_ptr<btCollisionShape>(new btScaledBvhTriangleMeshShape(bvhShape, glmToBullet(scale)),
+            [meshShape](btCollisionShape* scaledShape) { delete scaledShape; });
+    }
+
+    std::shared_ptr<btCollisionShape> BulletColliderComponent::createConvexHullShape(CollisionShapeCache* shapeCache) {
+        if (!mesh || mesh->vertices.empty()) {
+            return std::make_shared<btBoxShape>(btVector3(0.5f, 0.5f, 0.5f)); // Fallback
+        }
+
+        // The hull points are picked once per mesh and the hulls of the other scales copy them
+        CollisionShapeKey hullKey;
+        hullKey.type = CollisionShape::CONVEX_HULL;
+        hullKey.size = glm::vec3(1.0f);
+        hullKey.mesh = mesh;
+        auto create = [this]() {
+            // The number of points is bounded since the narrow phase cost grows with it
+            std::vector<glm::vec3> points = mesh_utils::convexHullPoints(*mesh, MAX_HULL_POINTS);
+            auto hull = std::make_shared<btConvexHullShape>();
+            for (const auto& point : points) {
+                hull->addPoint(glmToBullet(point), false);
+            }
+            hull->recalcLocalAabb();
+            std::cout << "BulletCollider: Created convex hull with " << points.size() << " points from "
+                      << mesh->vertices.size() << " vertices" << std::endl;
+            return std::shared_ptr<btCollisionShape>(hull);
+        };
+        std::shared_ptr<btCollisionShape> hullShape = shapeCache ? shapeCache->get(hullKey, create) : create();
+
+        glm::vec3 scale = getWorldScale();
+        if (glm::all(glm::epsilonEqual(scale, glm::vec3(1.0f), 1e-5f))) return hullShape;
+        auto* unscaledHull = static_cast<btConvexHullShape*>(hullShape.get());
+        auto scaledHull = std::make_shared<btConvexHullShape>(
+            reinterpret_cast<const btScalar*>(unscaledHull->getUnscaledPoints()), unscaledHull->getNumPoints());
+        scaledHull->setLocalScaling(glmToBullet(scale));
+        return scaledHull;
+    }
+
+    std::shared_ptr<btCollisionShape> BulletColliderComponent::createDecomposedShape(CollisionShapeCache* shapeCache) {
+        if (!mesh || mesh->vertices.empty()) {
+            return std::make_shared<btBoxShape>(btVector3(0.5f, 0.5f, 0.5f)); // Fallback
+        }
+        // The decomposition is cached in memory and on disk, so this is only slow the first time a mesh is used
+        convex_decomposition::Parts parts = convex_decomposition::get(*mesh);
+        if (parts.empty()) return createConvexHullShape(shapeCache);
+
+        // The scale is applied to the points of the parts since the compound would scale its children in place
+        glm::vec3 scale = getWorldScale();
+        btCompoundShape* compound = new btCompoundShape(true, static_cast<int>(parts.size()));
+        btTransform identity;
+        identity.setIdentity();
+        for (const auto& part : parts) {
+            btConvexHullShape* hull = new btConvexHullShape();
+            for (const auto& point : part) {
+                hull->addPoint(glmToBullet(point * scale), false);
+            }
+            hull->recalcLocalAabb();
+            compound->addChildShape(identity, hull);
+        }
+        std::cout << "BulletCollider: Created compound collider with " << parts.size() << " convex parts" << std::endl;
+
+        // The compound doesn't own its children, so they are deleted with it
+        return std::shared_ptr<btCollisionShape>(compound, [](btCollisionShape* shape) {
+            btCompoundShape* compoundShape = static_cast<btCompoundShape*>(shape);
+            for (int child = 0; child < compoundShape->getNumChildShapes(); ++child) {
+                delete compoundShape->getChildShape(child);
+            }
+            delete compoundShape;
+        });
+    }
+
+    glm::vec3 BulletColliderComponent::getWorldScale() const {
+        if (!getOwner()) return glm::vec3(1.0f);
+        glm::mat4 transform = getOwner()->getLocalToWorldMatrix();
+        return glm::vec3(glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])));
+    }
+
+    btTransform BulletColliderComponent::getEntityTransform() const {
+        glm::mat4 transform = getOwner()->getLocalToWorldMatrix();
+        glm::vec3 position = glm::vec3(transform[3]) + centerOffset;
+        // The scale is removed from the basis before extracting the rotation (the shapes apply the scale themselves)
+        glm::mat3 basis(glm::normalize(glm::vec3(transform[0])), glm::normalize(glm::vec3(transform[1])), glm::normalize(glm::vec3(transform[2])));
+        glm::quat rotation = glm::quat_cast(basis);
+
+        btTransform result;
+        result.setOrigin(glmToBullet(position));
+        result.setRotation(btQuaternion(rotation.x, rotation.y, rotation.z, rotation.w));
+        return result;
+    }
+
+    void BulletColliderComponent::initialize(btDiscreteDynamicsWorld* world, CollisionShapeCache* shapeCache) {
         if (!getOwner()) return;
 
-        // Create collision shape
-        collisionShape = createShape();
+        // Create collision shape (or share the one of a collider with the same configuration)
+        if (shapeCache) {
+            collisionShape = shapeCache->get(getShapeKey(), [this, shapeCache]() { return createShape(shapeCache); });
+        } else {
+            collisionShape = createShape(nullptr);
+        }
         if (!collisionShape) return;
 
         // Create motion state
-        btTransform startTransform;
-        startTransform.setIdentity();
-        
-        // For mesh colliders (static), transform is baked into vertices, so use identity
-        if (shapeType == CollisionShape::MESH && mass == 0.0f) {
-            startTransform.setOrigin(btVector3(0, 0, 0));
-            startTransform.setRotation(btQuaternion(0, 0, 0, 1));
-        } else {
-            // For dynamic objects, use entity transform
-            glm::mat4 transform = getOwner()->getLocalToWorldMatrix();
-            glm::vec3 position = glm::vec3(transform[3]) + centerOffset;
-            
-            // Extract rotation quaternion from transform matrix
-            glm::quat rotation = glm::quat_cast(transform);
-            
-            startTransform.setOrigin(glmToBullet(position));
-            startTransform.setRotation(btQuaternion(rotation.x, rotation.y, rotation.z, rotation.w));
-        }
+        // The body is placed at the entity (mesh colliders included since their triangles stay in the mesh local space)
+        btTransform startTransform = getEntityTransform();
+        previousTransform = startTransform;
 
         motionState = new btDefaultMotionState(startTransform);
 
@@ -235,7 +382,7 @@ namespace our {
         }
 
         // Create rigid body
-        btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, motionState, collisionShape, localInertia);
+        btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, motionState, collisionShape.get(), localInertia);
         rbInfo.m_friction = friction;
         rbInfo.m_restitution = restitution;
 
@@ -256,41 +403,37 @@ namespace our {
                                         btCollisionObject::CF_NO_CONTACT_RESPONSE);
         }
 
-        // Add to world
+        // Add to world (the broadphase only pairs it with the colliders whose groups match its mask)
         if (world) {
-            world->addRigidBody(rigidBody);
+            world->addRigidBody(rigidBody, getCollisionGroup(), getCollisionMask());
         }
 
         // Store pointer to this component in user data for collision callbacks
         rigidBody->setUserPointer(this);
     }
 
-    void BulletColliderComponent::syncToEntity() {
+    void BulletColliderComponent::syncToEntity(float interpolation) {
         if (!rigidBody || !getOwner() || mass == 0.0f) return;
 
         btTransform trans;
         rigidBody->getMotionState()->getWorldTransform(trans);
 
         // Get position from Bullet
-        btVector3 pos = trans.getOrigin();
+        btVector3 pos = previousTransform.getOrigin().lerp(trans.getOrigin(), interpolation);
 
         // Convert to glm
         glm::vec3 position = bulletToGlm(pos) - centerOffset;
 
         // Update entity position only (rotation is controlled by mouse input)
-        getOwner()->localTransform.position = position;
+        getOwner()->editLocalTransform().position = position;
     }
 
     void BulletColliderComponent::syncFromEntity() {
         if (!rigidBody || !getOwner()) return;
 
-        glm::mat4 transform = getOwner()->getLocalToWorldMatrix();
-        glm::vec3 position = glm::vec3(transform[3]) + centerOffset;
-        glm::quat rotation = glm::quat_cast(transform);
-
-        btTransform trans;
-        trans.setOrigin(glmToBullet(position));
-        trans.setRotation(btQuaternion(rotation.x, rotation.y, rotation.z, rotation.w));
+        btTransform trans = getEntityTransform();
+        // A teleport is not interpolated
+        previousTransform = trans;
 
         // For dynamic objects, move directly (Bullet will handle collision response)
         if (mass > 0.0f) {
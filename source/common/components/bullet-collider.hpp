@@ -5,9 +5,13 @@
 #include <btBulletDynamicsCommon.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <memory>
 
 namespace our {
 
+    class CollisionShapeCache;
+    struct CollisionShapeKey;
+
     // Collision shape types supported by Bullet
     enum class CollisionShape {
         BOX,
@@ -15,16 +19,20 @@ namespace our {
         CAPSULE,
         CYLINDER,
         MESH,
-        CONVEX_HULL
+        CONVEX_HULL,
+        DECOMPOSED      // A compound of the convex parts of the mesh (for concave dynamic objects)
     };
 
     // This component adds Bullet Physics collision to an entity
     class BulletColliderComponent : public Component {
     public:
         // Bullet physics objects
-        btCollisionShape* collisionShape;
+        // The shape may be shared with other colliders that have the same configuration (see CollisionShapeCache)
+        std::shared_ptr<btCollisionShape> collisionShape;
         btRigidBody* rigidBody;
         btDefaultMotionState* motionState;
+        // The body transform before the last physics step (used to interpolate between steps)
+        btTransform previousTransform;
         
         // Configuration
         CollisionShape shapeType;
@@ -33,6 +41,11 @@ namespace our {
         float friction;
         float restitution;        // Bounciness (0-1)
         bool isTrigger;          // If true, no physical response, just collision detection
+        bool reportContacts;      // If true, the contacts of this collider are reported as collision events (triggers always are)
+        // The collision group bits of this collider and the groups it collides with (0 = chosen by the body type)
+        // Two colliders only collide if each one's group is in the other's mask, so the broadphase never pairs the others
+        int collisionGroup;
+        int collisionMask;
         glm::vec3 centerOffset;   // Offset from entity position
         
         // Reference to mesh for mesh/convex hull shapes
@@ -40,6 +53,9 @@ namespace our {
         
         // Constructor
         BulletColliderComponent();
+        // Copies the configuration only (used to clone prefabs), the copy gets its own Bullet objects when it is initialized
+        BulletColliderComponent(const BulletColliderComponent& other);
+        BulletColliderComponent& operator=(const BulletColliderComponent&) = delete;
         
         // The ID of this component type is "Bullet Collider"
         static std::string getID() { return "Bullet Collider"; }
@@ -48,10 +64,23 @@ namespace our {
         void deserialize(const nlohmann::json& data) override;
         
         // Initialize the collision shape and rigid body
-        void initialize(btDiscreteDynamicsWorld* world);
+        // If a shape cache is given, the shape is taken from it (or created and added to it)
+        void initialize(btDiscreteDynamicsWorld* world, CollisionShapeCache* shapeCache = nullptr);
+
+        // Returns the key that identifies the shape of this collider in a shape cache
+        CollisionShapeKey getShapeKey() const;
+
+        // Returns the collision group and mask used for the body (the automatic ones if they were not set)
+        int getCollisionGroup() const;
+        int getCollisionMask() const;
+
+        // Returns the bit of a named collision group ("default", "static", "kinematic", "debris", "trigger", "character",
+        // "player", "zombie", "prop") or 0 if the name is unknown
+        static int getCollisionGroupBit(const std::string& name);
         
         // Update entity transform from physics simulation
-        void syncToEntity();
+        // The position is interpolated between the previous and the current step by the given fraction
+        void syncToEntity(float interpolation = 1.0f);
         
         // Update physics simulation from entity transform
         void syncFromEntity();
@@ -60,8 +89,25 @@ namespace our {
         ~BulletColliderComponent();
         
     private:
-        // Helper to create collision shapes
-        btCollisionShape* createShape();
+        // Helper to create collision shapes (the cache is used to share the triangles of mesh shapes with different scales)
+        std::shared_ptr<btCollisionShape> createShape(CollisionShapeCache* shapeCache);
+
+        // Helpers to create the mesh shapes: the unscaled triangle mesh of the mesh and its scaled version for this entity
+        static std::shared_ptr<btCollisionShape> createTriangleMeshShape(const Mesh* mesh);
+        std::shared_ptr<btCollisionShape> createMeshShape(CollisionShapeCache* shapeCache);
+
+        // The maximum number of points in the convex hull shapes
+        static constexpr int MAX_HULL_POINTS = 32;
+        // Helper to create the convex hull shape of the mesh scaled by the entity scale
+        std::shared_ptr<btCollisionShape> createConvexHullShape(CollisionShapeCache* shapeCache);
+        // Helper to create the compound of the convex parts of the mesh scaled by the entity scale
+        std::shared_ptr<btCollisionShape> createDecomposedShape(CollisionShapeCache* shapeCache);
+
+        // Returns the scale of the entity in the world space
+        glm::vec3 getWorldScale() const;
+
+        // Returns the entity position (with the center offset) and rotation (without the scale) in the world space
+        btTransform getEntityTransform() const;
         
         // Helper to convert glm to Bullet vectors
         btVector3 glmToBullet(const glm::vec3& v) const {
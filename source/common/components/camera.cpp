@@ -1,9 +1,12 @@
 #include "camera.hpp"
-#include "../ecs/entity.hpp"
+#include "../ecs/component-registry.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp> 
 
 namespace our {
+
+    OUR_REGISTER_COMPONENT(CameraComponent)
+
     // Reads camera parameters from the given json object
     void CameraComponent::deserialize(const nlohmann::json& data){
         if(!data.is_object()) return;
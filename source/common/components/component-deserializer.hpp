@@ -1,35 +1,22 @@
 #pragma once
 
-#include "../ecs/entity.hpp"
-#include "camera.hpp"
-#include "mesh-renderer.hpp"
-#include "free-camera-controller.hpp"
-#include "movement.hpp"
-#include "light.hpp"
-#include "bullet-collider.hpp"
+#include "../ecs/world.hpp"
+#include "../ecs/component-registry.hpp"
 
 namespace our {
 
     // Given a json object, this function picks and creates a component in the given entity
     // based on the "type" specified in the json object which is later deserialized from the rest of the json object
+    // The type is looked up in the component registry, where each component type registers itself (see "OUR_REGISTER_COMPONENT")
     inline void deserializeComponent(const nlohmann::json& data, Entity* entity){
-        std::string type = data.value("type", "");
-        Component* component = nullptr;
-        //TODO: (Req 8) Add an option to deserialize a "MeshRendererComponent" to the following if-else statement
-        if(type == CameraComponent::getID()){
-            component = entity->addComponent<CameraComponent>();
-        } else if (type == FreeCameraControllerComponent::getID()) {
-            component = entity->addComponent<FreeCameraControllerComponent>();
-        } else if (type == MovementComponent::getID()) {
-            component = entity->addComponent<MovementComponent>();
-        } else if (type == MeshRendererComponent::getID()) {
-            component = entity->addComponent<MeshRendererComponent>();
-        } else if (type == LightComponent::getID()) {
-            component = entity->addComponent<LightComponent>();
-		} else if (type == BulletColliderComponent::getID()) {
-            component = entity->addComponent<BulletColliderComponent>();
-		}
-        if(component) component->deserialize(data);
+        if(!data.is_object()) return;
+        auto type = data.find("type");
+        if(type == data.end() || !type->is_string()) return;
+        // Read the name in place instead of copying it into a new string
+        if(ComponentRegistry::Factory factory = ComponentRegistry::find(type->get_ref<const std::string&>())){
+            Component* component = factory(entity);
+            component->deserialize(data);
+        }
     }
 
-}
\ No newline at end of file
+}
@@ -1,8 +1,11 @@
 #include "free-camera-controller.hpp"
-#include "../ecs/entity.hpp"
+#include "../ecs/component-registry.hpp"
 #include "../deserialize-utils.hpp"
 
 namespace our {
+
+    OUR_REGISTER_COMPONENT(FreeCameraControllerComponent)
+
     // Reads sensitivities & speedupFactor from the given json object
     void FreeCameraControllerComponent::deserialize(const nlohmann::json& data){
         if(!data.is_object()) return;
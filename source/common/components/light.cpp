@@ -1,8 +1,10 @@
 #include "light.hpp"
-#include "../ecs/entity.hpp"
+#include "../ecs/component-registry.hpp"
 
 namespace our {
 
+    OUR_REGISTER_COMPONENT(LightComponent)
+
     void LightComponent::deserialize(const nlohmann::json& data) {
         if (!data.is_object()) return;
 
@@ -1,7 +1,11 @@
 #include "mesh-renderer.hpp"
+#include "../ecs/component-registry.hpp"
 #include "../asset-loader.hpp"
 
 namespace our {
+
+    OUR_REGISTER_COMPONENT(MeshRendererComponent)
+
     // Receives the mesh & material from the AssetLoader by the names given in the json object
     void MeshRendererComponent::deserialize(const nlohmann::json& data){
         if(!data.is_object()) return;
@@ -12,6 +12,7 @@ namespace our {
     public:
         Mesh* mesh; // The mesh that should be drawn
         Material* material; // The material used to draw the mesh
+        int lod = 0; // The level of detail picked by the renderer in the last frame (kept to apply hysteresis)
 
         // The ID of this component type is "Mesh Renderer"
         static std::string getID() { return "Mesh Renderer"; }
@@ -1,8 +1,11 @@
 #include "movement.hpp"
-#include "../ecs/entity.hpp"
+#include "../ecs/component-registry.hpp"
 #include "../deserialize-utils.hpp"
 
 namespace our {
+
+    OUR_REGISTER_COMPONENT(MovementComponent)
+
     // Reads linearVelocity & angularVelocity from the given json object
     void MovementComponent::deserialize(const nlohmann::json& data){
         if(!data.is_object()) return;
@@ -0,0 +1,39 @@
+#include "component-registry.hpp"
+
+#include <deque>
+#include <iostream>
+#include <unordered_map>
+
+namespace our {
+
+    namespace {
+        // The registered names and factories. They are created on first use since the registrations run
+        // during static initialization in other translation units (whose order is not defined).
+        struct Registry {
+            std::deque<std::string> names; // The interned names (a deque never moves its elements, so the views stay valid)
+            std::unordered_map<std::string_view, ComponentRegistry::Factory> factories;
+        };
+        Registry& getRegistry() {
+            static Registry registry;
+            return registry;
+        }
+    }
+
+    bool ComponentRegistry::add(const std::string& name, Factory factory) {
+        Registry& registry = getRegistry();
+        if (registry.factories.count(name)) {
+            std::cerr << "ERROR: The component type \"" << name << "\" is registered more than once" << std::endl;
+            return false;
+        }
+        const std::string& interned = registry.names.emplace_back(name);
+        registry.factories.emplace(interned, factory);
+        return true;
+    }
+
+    ComponentRegistry::Factory ComponentRegistry::find(std::string_view name) {
+        Registry& registry = getRegistry();
+        if (auto it = registry.factories.find(name); it != registry.factories.end()) return it->second;
+        return nullptr;
+    }
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "world.hpp"
+
+#include <string>
+#include <string_view>
+
+namespace our {
+
+    // The registry maps the component type names used in the scene files (see Component::getID) to functions that
+    // add a component of that type to an entity. The component types register themselves at static initialization time
+    // using the macro "OUR_REGISTER_COMPONENT" in their source file, so adding a new type doesn't touch any shared code
+    // and finding a type costs a single hash lookup however many types there are.
+    class ComponentRegistry {
+    public:
+        // A function that adds a new component to the given entity and returns it
+        using Factory = Component* (*)(Entity*);
+
+        // Registers the factory of a component type. Returns false if the name was already registered.
+        static bool add(const std::string& name, Factory factory);
+        // Returns the factory registered with the given name (or nullptr if no type has that name)
+        static Factory find(std::string_view name);
+    };
+
+    // Registers the component type T under the name returned by T::getID()
+    // Its factory adds the component using Entity::addComponent
+    template<typename T>
+    struct ComponentRegistration {
+        ComponentRegistration() {
+            ComponentRegistry::add(T::getID(), [](Entity* entity) -> Component* { return entity->addComponent<T>(); });
+        }
+    };
+
+}
+
+// Registers a component type in the component registry. Use it once in the source file of the component, e.g.:
+//      OUR_REGISTER_COMPONENT(MovementComponent)
+#define OUR_REGISTER_COMPONENT(Type) \
+    namespace { const ::our::ComponentRegistration<Type> ourComponentRegistration_##Type; }
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "component.hpp"
+#include "object-pool.hpp"
+
+#include <memory>
+#include <utility>
+
+namespace our {
+
+    // The type-erased interface of a component storage
+    // It lets the world and the entities destroy components without knowing their types
+    class ComponentStorageBase {
+    public:
+        // Calls the destructor of the given component and frees its slot to be reused by the next created component
+        virtual void destroy(Component* component) = 0;
+        // Destroys the component in the given slot (as returned by "emplace")
+        virtual void destroyAt(size_t slot) = 0;
+        // Constructs a copy of the given component (which must be of the storage type) and returns it with the index of its slot
+        virtual std::pair<Component*, size_t> clone(const Component* source) = 0;
+        // Creates an empty storage for the same component type
+        virtual std::unique_ptr<ComponentStorageBase> createEmpty() const = 0;
+        // Destroys all the components at once (the memory is kept for the next components)
+        virtual void clear() = 0;
+        // Returns the number of live components in this storage
+        virtual size_t size() const = 0;
+        virtual ~ComponentStorageBase() = default;
+    };
+
+    // This class stores all the components of type T in contiguous arrays (chunks) instead of allocating each on the heap
+    // so that the systems walking over the components of a type read packed memory.
+    // The chunks are never moved or freed while the storage is alive, so the component addresses stay stable
+    // (other objects such as the Bullet rigid bodies keep pointers to the components).
+    // The slots of destroyed components are reused by the next created components.
+    template<typename T>
+    class ComponentStorage : public ComponentStorageBase {
+        static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+
+        ObjectPool<T> pool;
+    public:
+        ComponentStorage() = default;
+
+        // Constructs a new component in a free slot and returns a pointer to it
+        T* create(){ return pool.create(); }
+        // Constructs a new component in a free slot and returns a pointer to it with the index of its slot
+        std::pair<T*, size_t> emplace(){ return pool.emplace(); }
+
+        void destroy(Component* component) override { pool.destroy(static_cast<T*>(component)); }
+        void destroyAt(size_t slot) override { pool.destroyAt(slot); }
+
+        // The component is copy constructed, so components that own runtime objects (e.g. physics bodies)
+        // must define a copy constructor that only copies their configuration
+        std::pair<Component*, size_t> clone(const Component* source) override {
+            auto [component, slot] = pool.emplace(*static_cast<const T*>(source));
+            return {component, slot};
+        }
+        std::unique_ptr<ComponentStorageBase> createEmpty() const override {
+            return std::make_unique<ComponentStorage<T>>();
+        }
+
+        void clear() override { pool.clear(); }
+
+        size_t size() const override { return pool.size(); }
+
+        // Calls the given function for every live component in the storage (in the order of their slots)
+        template<typename Function>
+        void forEach(Function&& function){
+            pool.forEach(std::forward<Function>(function));
+        }
+
+        ComponentStorage(const ComponentStorage&) = delete;
+        ComponentStorage& operator=(const ComponentStorage&) = delete;
+    };
+
+}
@@ -2,11 +2,32 @@
 
 #include <json/json.hpp>
 #include <string>
+#include <cstdint>
+#include <atomic>
 
 namespace our {
 
     class Entity; // A forward declaration of the Entity Class
 
+    // A small integer that identifies each type of components at runtime without RTTI
+    // The IDs are given in the order in which the types are first used, so they are dense and can index arrays
+    using ComponentTypeID = std::uint32_t;
+
+    namespace detail {
+        // Returns a new ID every time it is called (it is atomic since the systems may query new types from different threads)
+        inline ComponentTypeID nextComponentTypeID() {
+            static std::atomic<ComponentTypeID> counter{0};
+            return counter.fetch_add(1);
+        }
+    }
+
+    // Returns the ID of the component type T (the same type always gets the same ID)
+    template<typename T>
+    ComponentTypeID getComponentTypeID() {
+        static const ComponentTypeID id = detail::nextComponentTypeID();
+        return id;
+    }
+
     // A component is a data container that can be added to an entity.
     // The role of the entity in the world is defined by the components it holds.
     // For example, an entity with a camera component specifies that this entity should be used as a camera
@@ -15,9 +36,9 @@ namespace our {
         Entity* owner; // A pointer to the entity that owns this component
         friend Entity; // The entity is a friend since it is the only one allowed to set itself as an owner of a certain component.
     public:
-        // This static method returns a unique string that identifies each type of components
-        // This ID will be used as the key to store a component into the entity's component map 
+        // This static method returns a unique string that identifies each type of components in the scene files
         // When you create a new type of components, override this function to return a new unique ID
+        // Note: this is only used while deserializing. At runtime, the components are found using "getComponentTypeID<T>()"
         static std::string getID() { return "Component"; }
         // Reads the data of the component from a json object
         // It is abstract since it must be overriden by derived components
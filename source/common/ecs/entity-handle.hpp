@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace our {
+
+    // A handle is a safe way to refer to an entity that may be destroyed.
+    // It packs the index of the entity's slot in the world's slot table with the generation of that slot.
+    // When an entity is destroyed, the generation of its slot is incremented, so the old handles stop matching
+    // and World::get returns nullptr for them instead of a dangling pointer.
+    class EntityHandle {
+    public:
+        static constexpr std::uint32_t INDEX_BITS = 20;        // Up to ~1M live entities
+        static constexpr std::uint32_t GENERATION_BITS = 32 - INDEX_BITS;
+        static constexpr std::uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+        static constexpr std::uint32_t GENERATION_MASK = (1u << GENERATION_BITS) - 1;
+        // The last generation is reserved for the null handle, so no live entity ever has the value of INVALID
+        static constexpr std::uint32_t MAX_GENERATION = GENERATION_MASK - 1;
+        static constexpr std::uint32_t INVALID = 0xFFFFFFFFu;
+
+        EntityHandle() = default;
+        EntityHandle(std::uint32_t index, std::uint32_t generation)
+            : value((index & INDEX_MASK) | ((generation & GENERATION_MASK) << INDEX_BITS)) {}
+
+        std::uint32_t getIndex() const { return value & INDEX_MASK; }
+        std::uint32_t getGeneration() const { return value >> INDEX_BITS; }
+        std::uint32_t getValue() const { return value; }
+        bool isNull() const { return value == INVALID; }
+
+        bool operator==(const EntityHandle& other) const { return value == other.value; }
+        bool operator!=(const EntityHandle& other) const { return value != other.value; }
+
+    private:
+        std::uint32_t value = INVALID;
+    };
+
+}
+
+template<>
+struct std::hash<our::EntityHandle> {
+    size_t operator()(const our::EntityHandle& handle) const noexcept { return std::hash<std::uint32_t>()(handle.getValue()); }
+};
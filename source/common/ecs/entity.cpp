@@ -3,6 +3,7 @@
 #include "../components/component-deserializer.hpp"
 
 #include <glm/gtx/euler_angles.hpp>
+#include <algorithm>
 
 namespace our {
 
@@ -10,7 +11,9 @@ namespace our {
     // Remember that you can get the transformation matrix from this entity to its parent from "localTransform"
     // To get the local to world matrix, you need to combine this entities matrix with its parent's matrix and
     // its parent's parent's matrix and so on till you reach the root.
+    // If the entity is not dirty, the matrix cached by the transform system is up to date so we return it directly
     glm::mat4 Entity::getLocalToWorldMatrix() const {
+        if (!transformDirty) return localToWorld;
         // local (this) -> parent -> parent's parent -> ... -> root
         glm::mat4 localMat = localTransform.toMat4();
         if (parent == nullptr) return localMat;
@@ -18,11 +21,54 @@ namespace our {
         return parent->getLocalToWorldMatrix() * localMat;
     }
 
+    void Entity::setParent(Entity* newParent) {
+        if (newParent == parent) return;
+        if (parent) {
+            auto& siblings = parent->children;
+            siblings.erase(std::remove(siblings.begin(), siblings.end(), this), siblings.end());
+        }
+        parent = newParent;
+        if (parent) parent->children.push_back(this);
+        ++world->hierarchyVersion;
+        // The entity may be dirty only because of its old ancestors, so we add it to the dirty list to keep it reachable
+        world->dirtyTransforms.push_back(this);
+        markSubtreeDirty();
+    }
+
+    void Entity::markTransformDirty() {
+        // If the entity is already dirty, its descendants are dirty too and it is already reachable from the dirty list
+        if (transformDirty) return;
+        world->dirtyTransforms.push_back(this);
+        markSubtreeDirty();
+    }
+
+    void Entity::markSubtreeDirty() {
+        if (!transformDirty) ++world->dirtyTransformCount;
+        transformDirty = true;
+        for (Entity* child : children) {
+            if (!child->transformDirty) child->markSubtreeDirty();
+        }
+    }
+
+    void Entity::cloneComponents(const Entity* source) {
+        components.reserve(components.size() + source->components.size());
+        for (const auto& entry : source->components) {
+            // Find (or create) the storage of the component type in our world
+            auto& storages = world->storages;
+            if (entry.type >= storages.size()) storages.resize(entry.type + 1);
+            auto& storage = storages[entry.type];
+            if (!storage) storage = entry.storage->createEmpty();
+            auto [component, slot] = storage->clone(entry.component);
+            component->owner = this;
+            components.push_back({component, storage.get(), slot, entry.type});
+        }
+    }
+
     // Deserializes the entity data and components from a json object
     void Entity::deserialize(const nlohmann::json& data){
         if(!data.is_object()) return;
         name = data.value("name", name);
-        localTransform.deserialize(data);
+        editLocalTransform().deserialize(data);
         if(data.contains("components")){
             if(const auto& components = data["components"]; components.is_array()){
                 for(auto& component: components){
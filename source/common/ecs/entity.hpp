@@ -1,76 +1,124 @@
 #pragma once
 
 #include "component.hpp"
+#include "component-storage.hpp"
 #include "transform.hpp"
-#include <list>
-#include <iterator>
+#include "entity-handle.hpp"
+#include <vector>
 #include <string>
 #include <glm/glm.hpp>
+#include <type_traits>
 
 namespace our {
 
     class World; // A forward declaration of the World Class
 
     class Entity{
+        // Each component is stored in the component storage of its type (owned by the world)
+        // so the entity keeps the storage alongside the component to be able to destroy it
+        struct ComponentEntry {
+            Component* component;
+            ComponentStorageBase* storage;
+            size_t slot; // The slot of the component in its storage
+            ComponentTypeID type;
+        };
+
         World *world; // This defines what world own this entity
-        std::list<Component*> components; // A list of components that are owned by this entity
+        std::vector<ComponentEntry> components; // The components that are owned by this entity
+        size_t worldIndex; // The index of this entity in the entities array of its world
+        size_t poolIndex;  // The slot of this entity in the entity pool of its world
+        EntityHandle handle; // The handle that refers to this entity
+        bool markedForRemoval = false; // Is this entity waiting in the removal queue of its world
+
+        Entity* parent = nullptr;       // The parent of the entity. The transform of the entity is relative to its parent.
+                                        // If parent is null, the entity is a root entity (has no parent).
+        std::vector<Entity*> children;  // The entities whose parent is this entity
+        Transform localTransform;       // The transform of this entity relative to its parent.
+
+        // The cached local to world matrix. It is only valid if "transformDirty" is false.
+        // If an entity is dirty, all of its descendants are dirty too.
+        glm::mat4 localToWorld = glm::mat4(1.0f);
+        bool transformDirty = true;
+
+        // Marks this entity and its descendants as dirty without adding them to the dirty list of the world
+        void markSubtreeDirty();
+
+        // Adds copies of the components of the given entity to this entity (used by World::instantiate)
+        void cloneComponents(const Entity* source);
 
         friend World; // The world is a friend since it is the only class that is allowed to instantiate an entity
+        template<typename> friend class ObjectPool; // The entities are constructed in the entity pool of the world
+        friend class TransformSystem; // The transform system updates the cached matrices
         Entity() = default; // The entity constructor is private since only the world is allowed to instantiate an entity
     public:
         std::string name; // The name of the entity. It could be useful to refer to an entity by its name
-        Entity* parent;   // The parent of the entity. The transform of the entity is relative to its parent.
-                          // If parent is null, the entity is a root entity (has no parent).
-        Transform localTransform; // The transform of this entity relative to its parent.
 
         World* getWorld() const { return world; } // Returns the world to which this entity belongs
+        EntityHandle getHandle() const { return handle; } // Returns a handle that can be kept safely after the entity is removed
+        bool isMarkedForRemoval() const { return markedForRemoval; }
+
+        Entity* getParent() const { return parent; }
+        const std::vector<Entity*>& getChildren() const { return children; }
+        // Changes the parent of this entity (nullptr makes it a root entity). The local transform is kept as is.
+        void setParent(Entity* newParent);
 
-        glm::mat4 getLocalToWorldMatrix() const; // Computes and returns the transformation from the entities local space to the world space
+        // Returns the transform of this entity relative to its parent
+        const Transform& getLocalTransform() const { return localTransform; }
+        // Returns the transform of this entity relative to its parent to be modified and marks the entity as dirty
+        // so its world matrix (and the world matrices of its descendants) will be recomputed by the transform system.
+        // Call it only when the transform is going to change.
+        Transform& editLocalTransform() {
+            markTransformDirty();
+            return localTransform;
+        }
+        // Marks the world matrix of this entity and its descendants as outdated
+        void markTransformDirty();
+
+        // Returns the transformation from the entities local space to the world space
+        // If the transform system already updated the entity, the cached matrix is returned,
+        // otherwise, it is computed from the transforms of the entity and its ancestors
+        glm::mat4 getLocalToWorldMatrix() const;
         void deserialize(const nlohmann::json&); // Deserializes the entity data and components from a json object
         
-        // This template method create a component of type T,
-        // adds it to the components map and returns a pointer to it 
+        // This template method create a component of type T in the component storage of the world,
+        // adds it to the components list and returns a pointer to it
+        // It is defined in "world.hpp" since it needs the world definition
         template<typename T>
-        T* addComponent(){
-            static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
-            //TODO: (Req 8) Create an component of type T, set its "owner" to be this entity, then push it into the component's list
-            // Don't forget to return a pointer to the new component
-		T* component = new T();
-		component->owner = this;
-		components.push_back(component);
-		return component;
-        }
+        T* addComponent();
 
         // This template method searhes for a component of type T and returns a pointer to it
         // If no component of type T was found, it returns a nullptr 
+        // The components are matched by their type ID, so T must be the exact type of the component (not one of its bases)
         template<typename T>
         T* getComponent(){
-            // Go through the components list and find the first component that can be dynamically cast to "T*".
-            for(auto c : components){
-                if(auto casted = dynamic_cast<T*>(c)) return casted;
+            ComponentTypeID type = getComponentTypeID<T>();
+            for(auto& entry : components){
+                if(entry.type == type) return static_cast<T*>(entry.component);
             }
             return nullptr;
         }
 
-        // This template method dynami and returns a pointer to it
-        // If no component of type T was found, it returns a nullptr 
+        // This template method returns the component at the given index if it is of type T
+        // If the index is out of range or the component is not of type T, it returns a nullptr 
         template<typename T>
         T* getComponent(size_t index){
-            auto it = components.begin();
-            std::advance(it, index);
-            if(it != components.end())
-                return dynamic_cast<T*>(*it);
-            return nullptr;
+            if(index >= components.size()) return nullptr;
+            if constexpr (std::is_same<T, Component>::value) {
+                return components[index].component;
+            } else {
+                if(components[index].type == getComponentTypeID<T>())
+                    return static_cast<T*>(components[index].component);
+                return nullptr;
+            }
         }
 
         // This template method searhes for a component of type T and deletes it
         template<typename T>
         void deleteComponent() {
-            //TODO: (Req 8) Go through the components list and find the first component that can be dynamically cast to "T*".
-            // If found, delete the found component and remove it from the components list
+            ComponentTypeID type = getComponentTypeID<T>();
             for (auto it = components.begin(); it != components.end(); ++it) {
-                if (auto comp = dynamic_cast<T*>(*it)) {
-                    delete comp;
+                if (it->type == type) {
+                    it->storage->destroyAt(it->slot);
                     components.erase(it);
                     return;
                 }
@@ -79,10 +127,9 @@ namespace our {
 
         // This template method searhes for a component of type T and deletes it
         void deleteComponent(size_t index){
-            auto it = components.begin();
-            std::advance(it, index);
-            if(it != components.end()) {
-                delete *it;
+            if(index < components.size()) {
+                auto it = components.begin() + index;
+                it->storage->destroyAt(it->slot);
                 components.erase(it);
             }
         }
@@ -91,8 +138,8 @@ namespace our {
         template<typename T>
         void deleteComponent(T const* component) {
             for (auto it = components.begin(); it != components.end(); ++it) {
-                if (*it == component) {
-                    delete* it;
+                if (it->component == component) {
+                    it->storage->destroyAt(it->slot);
                     components.erase(it);
                     return;
                 }
@@ -101,8 +148,8 @@ namespace our {
 
         // Since the entity owns its components, they should be deleted alongside the entity
         ~Entity(){
-            // Delete all the components owned by this entity
-            for(auto c : components) delete c;
+            // Destroy all the components owned by this entity
+            for(auto& entry : components) entry.storage->destroyAt(entry.slot);
             components.clear();
         }
 
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define OUR_MATRIX_SSE 1
+#endif
+
+namespace our::simd {
+
+    // Returns a * b. With SSE, each column of the result is built from the 4 columns of "a" scaled by the components of
+    // the matching column of "b", using 4 multiplies and 3 adds on whole columns instead of 16 dot products.
+    // glm matrices are not guaranteed to be 16 bytes aligned so the columns are loaded and stored unaligned.
+    inline glm::mat4 multiply(const glm::mat4& a, const glm::mat4& b) {
+#ifdef OUR_MATRIX_SSE
+        const float* left = &a[0][0];
+        const float* right = &b[0][0];
+        __m128 a0 = _mm_loadu_ps(left);
+        __m128 a1 = _mm_loadu_ps(left + 4);
+        __m128 a2 = _mm_loadu_ps(left + 8);
+        __m128 a3 = _mm_loadu_ps(left + 12);
+        glm::mat4 result;
+        float* out = &result[0][0];
+        for(int column = 0; column < 4; ++column){
+            const float* b_column = right + 4 * column;
+            __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(b_column[0]));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(b_column[1])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(b_column[2])));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a3, _mm_set1_ps(b_column[3])));
+            _mm_storeu_ps(out + 4 * column, sum);
+        }
+        return result;
+#else
+        return a * b;
+#endif
+    }
+
+    // Returns a * b where b is an affine matrix (its missing last row is (0,0,0,1)), so the first 3 columns of the result
+    // only need the first 3 columns of "a" and the last one adds the last column of "a" as is.
+    inline glm::mat4 multiplyAffine(const glm::mat4& a, const glm::mat4x3& b) {
+#ifdef OUR_MATRIX_SSE
+        const float* left = &a[0][0];
+        __m128 a0 = _mm_loadu_ps(left);
+        __m128 a1 = _mm_loadu_ps(left + 4);
+        __m128 a2 = _mm_loadu_ps(left + 8);
+        __m128 a3 = _mm_loadu_ps(left + 12);
+        glm::mat4 result;
+        float* out = &result[0][0];
+        for(int column = 0; column < 4; ++column){
+            const glm::vec3& b_column = b[column];
+            __m128 sum = _mm_mul_ps(a0, _mm_set1_ps(b_column.x));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a1, _mm_set1_ps(b_column.y)));
+            sum = _mm_add_ps(sum, _mm_mul_ps(a2, _mm_set1_ps(b_column.z)));
+            if(column == 3) sum = _mm_add_ps(sum, a3);
+            _mm_storeu_ps(out + 4 * column, sum);
+        }
+        return result;
+#else
+        return a * glm::mat4(
+            glm::vec4(b[0], 0.0f), glm::vec4(b[1], 0.0f), glm::vec4(b[2], 0.0f), glm::vec4(b[3], 1.0f)
+        );
+#endif
+    }
+
+}
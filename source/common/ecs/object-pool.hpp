@@ -0,0 +1,116 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace our {
+
+    // This class stores objects of type T in fixed size chunks instead of allocating each one on the heap.
+    // The chunks are never moved while the pool is alive, so the object addresses stay stable,
+    // and the slots of destroyed objects are reused by the next created objects.
+    // "clear" destroys all the objects at once but keeps the chunks so the next objects reuse the same memory.
+    template<typename T>
+    class ObjectPool {
+        // The number of objects in each chunk
+        static constexpr size_t CHUNK_SIZE = 64;
+        struct Chunk {
+            alignas(T) unsigned char data[CHUNK_SIZE * sizeof(T)];
+            bool alive[CHUNK_SIZE] = {};
+        };
+
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        std::vector<size_t> freeSlots; // The indices of the slots whose objects were destroyed
+        size_t used = 0;               // The number of slots that were ever used since the last clear
+        size_t count = 0;              // The number of live objects
+
+        T* slot(size_t index) const {
+            return reinterpret_cast<T*>(chunks[index / CHUNK_SIZE]->data) + (index % CHUNK_SIZE);
+        }
+        bool& alive(size_t index) const {
+            return chunks[index / CHUNK_SIZE]->alive[index % CHUNK_SIZE];
+        }
+        // Returns the index of the slot holding the given object (or "used" if the object is not in this pool)
+        size_t indexOf(const T* object) const {
+            for(size_t chunk = 0; chunk < chunks.size(); ++chunk){
+                const T* first = reinterpret_cast<const T*>(chunks[chunk]->data);
+                if(object >= first && object < first + CHUNK_SIZE) return chunk * CHUNK_SIZE + (object - first);
+            }
+            return used;
+        }
+    public:
+        ObjectPool() = default;
+
+        // Constructs a new object in a free slot and returns a pointer to it with the index of its slot
+        // The index can be given to "destroyAt" to destroy the object without searching for its slot
+        template<typename... Args>
+        std::pair<T*, size_t> emplace(Args&&... args){
+            size_t index;
+            if(!freeSlots.empty()){
+                index = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                index = used++;
+                if(index / CHUNK_SIZE >= chunks.size()) chunks.push_back(std::make_unique<Chunk>());
+            }
+            T* object = new (slot(index)) T(std::forward<Args>(args)...);
+            alive(index) = true;
+            ++count;
+            return {object, index};
+        }
+
+        // Constructs a new object in a free slot and returns a pointer to it
+        template<typename... Args>
+        T* create(Args&&... args){
+            return emplace(std::forward<Args>(args)...).first;
+        }
+
+        // Calls the destructor of the object in the given slot and frees the slot
+        void destroyAt(size_t index){
+            if(index >= used || !alive(index)) return;
+            slot(index)->~T();
+            alive(index) = false;
+            freeSlots.push_back(index);
+            --count;
+        }
+
+        // Calls the destructor of the given object and frees its slot
+        // Prefer "destroyAt" if the slot index is known since this has to search for the chunk of the object
+        void destroy(T* object){
+            destroyAt(indexOf(object));
+        }
+
+        // Destroys all the live objects and keeps the chunks to be reused
+        void clear(){
+            for(size_t index = 0; index < used; ++index){
+                if(alive(index)){
+                    slot(index)->~T();
+                    alive(index) = false;
+                }
+            }
+            freeSlots.clear();
+            used = 0;
+            count = 0;
+        }
+
+        // Returns the number of live objects in this pool
+        size_t size() const { return count; }
+        // Returns the number of objects that the pool can hold without allocating a new chunk
+        size_t capacity() const { return chunks.size() * CHUNK_SIZE; }
+
+        // Calls the given function for every live object in the pool (in the order of their slots)
+        template<typename Function>
+        void forEach(Function&& function){
+            for(size_t index = 0; index < used; ++index){
+                if(alive(index)) function(slot(index));
+            }
+        }
+
+        ~ObjectPool(){ clear(); }
+
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+    };
+
+}
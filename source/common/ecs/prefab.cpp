@@ -0,0 +1,35 @@
+#include "prefab.hpp"
+
+namespace our {
+
+    void Prefab::deserialize(const nlohmann::json& data) {
+        if (!data.is_object()) return;
+        prototypes.clear();
+        // Deserializing the entity as a single element array gives us the children for free
+        prototypes.deserialize(nlohmann::json::array({data}));
+        root = nullptr;
+        for (Entity* entity : prototypes.getEntities()) {
+            if (entity->getParent() == nullptr) {
+                root = entity;
+                break;
+            }
+        }
+    }
+
+    Entity* Prefab::instantiate(World* world, Entity* parent) const {
+        if (!root || !world) return nullptr;
+        return world->instantiate(root, parent);
+    }
+
+    void Prefab::instantiate(World* world, const std::vector<Transform>& transforms, Entity* parent,
+                             std::vector<Entity*>* instances) const {
+        if (!root || !world) return;
+        if (instances) instances->reserve(instances->size() + transforms.size());
+        for (const Transform& transform : transforms) {
+            Entity* instance = world->instantiate(root, parent);
+            instance->editLocalTransform() = transform;
+            if (instances) instances->push_back(instance);
+        }
+    }
+
+}
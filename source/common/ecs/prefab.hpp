@@ -0,0 +1,33 @@
+#pragma once
+
+#include "world.hpp"
+
+#include <json/json.hpp>
+#include <vector>
+
+namespace our {
+
+    // A prefab is an entity (with its children) that is parsed once and then copied as many times as needed.
+    // The prototype entities are deserialized into a private world, so the component types and asset names are resolved once.
+    // Instantiating a prefab copy constructs the prototype components into the target world, which is much cheaper than
+    // deserializing the same json again, so spawning a wave of enemies mid-game doesn't stall the frame.
+    class Prefab {
+        World prototypes;           // The world that owns the prototype entities
+        Entity* root = nullptr;     // The root of the prefab
+    public:
+        // Deserializes the prefab from a json object describing an entity (in the same form as the world entities)
+        void deserialize(const nlohmann::json& data);
+
+        // Creates a copy of the prefab in the given world and returns its root
+        // If parent pointer is not null, the root will have its parent set to that given pointer
+        Entity* instantiate(World* world, Entity* parent = nullptr) const;
+
+        // Creates a copy of the prefab for each of the given transforms (the transform replaces the one of the prefab root)
+        // The roots of the copies are appended to "instances" if it is not null
+        void instantiate(World* world, const std::vector<Transform>& transforms, Entity* parent = nullptr,
+                         std::vector<Entity*>* instances = nullptr) const;
+
+        Entity* getRoot() const { return root; }
+    };
+
+}
@@ -1,29 +1,55 @@
 #include "entity.hpp"
 #include "../deserialize-utils.hpp"
 
-#include <glm/gtx/euler_angles.hpp>
-
 namespace our {
 
+    // The quaternion matches glm::yawPitchRoll(euler.y, euler.x, euler.z) which rotates by the roll first, then the pitch then the yaw
+    void Transform::setEulerRotation(const glm::vec3& euler) {
+        eulerRotation = euler;
+        rotation = glm::angleAxis(euler.y, glm::vec3(0, 1, 0))
+                 * glm::angleAxis(euler.x, glm::vec3(1, 0, 0))
+                 * glm::angleAxis(euler.z, glm::vec3(0, 0, 1));
+        basis = glm::mat3_cast(rotation);
+    }
+
+    void Transform::setRotation(const glm::quat& quaternion) {
+        rotation = glm::normalize(quaternion);
+        basis = glm::mat3_cast(rotation);
+        // Extract the angles of R = Ry(yaw) * Rx(pitch) * Rz(roll) from the basis
+        float pitch = glm::asin(glm::clamp(-basis[2][1], -1.0f, 1.0f));
+        float yaw, roll;
+        if (glm::abs(basis[2][1]) < 0.9999f) {
+            yaw = glm::atan(basis[2][0], basis[2][2]);
+            roll = glm::atan(basis[0][1], basis[1][1]);
+        } else {
+            // Looking straight up or down, so only the sum of the yaw and roll is known
+            yaw = glm::atan(-basis[0][2], basis[0][0]);
+            roll = 0.0f;
+        }
+        eulerRotation = glm::vec3(pitch, yaw, roll);
+    }
+
     // This function computes and returns a matrix that represents this transform
     // Remember that the order of transformations is: Scaling, Rotation then Translation
-    // HINT: to convert euler angles to a rotation matrix, you can use glm::yawPitchRoll
+    // Instead of multiplying 3 matrices, each basis column is scaled and the position is put in the last column
     glm::mat4 Transform::toMat4() const {
-        //TODO: (Req 3) Write this function
-        glm::mat4 mat_T = glm::translate(glm::mat4(1.0f), position);
-        glm::mat4 mat_R = glm::yawPitchRoll(rotation.y, rotation.x, rotation.z);
-        glm::mat4 mat_S = glm::scale(glm::mat4(1.0f), scale);
-        glm::mat4 Transform_mat = mat_T * mat_R * mat_S;
+        return glm::mat4(
+            glm::vec4(basis[0] * scale.x, 0.0f),
+            glm::vec4(basis[1] * scale.y, 0.0f),
+            glm::vec4(basis[2] * scale.z, 0.0f),
+            glm::vec4(position, 1.0f)
+        );
+    }
 
-        return Transform_mat;
-        // return glm::mat4(1.0f);
+    glm::mat4x3 Transform::toAffine() const {
+        return glm::mat4x3(basis[0] * scale.x, basis[1] * scale.y, basis[2] * scale.z, position);
     }
 
     // Deserializes the entity data and components from a json object
     void Transform::deserialize(const nlohmann::json& data) {
         position = data.value("position", position);
-        rotation = glm::radians(data.value("rotation", glm::degrees(rotation)));
+        setEulerRotation(glm::radians(data.value("rotation", glm::degrees(eulerRotation))));
         scale = data.value("scale", scale);
     }
 
-}
\ No newline at end of file
+}
@@ -1,21 +1,45 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <json/json.hpp>
 
 namespace our {
 
     // A transform defines the translation, rotation & scale of an object relative to its parent
+    // The rotation is stored as a quaternion alongside the rotation matrix (basis) it represents, so building the matrix of the
+    // transform only scales the basis columns and appends the position. The euler angles are kept too since they are what the
+    // scene files and the camera controllers work with.
     struct Transform {
     public:
         glm::vec3 position = glm::vec3(0, 0, 0); // The position is defined as a vec3. (0,0,0) means no translation
-        glm::vec3 rotation = glm::vec3(0, 0, 0); // The rotation is defined using euler angles (y: yaw, x: pitch, z: roll). (0,0,0) means no rotation
         glm::vec3 scale = glm::vec3(1, 1, 1); // The scale is defined as a vec3. (1,1,1) means no scaling.
 
+        // Returns the rotation as euler angles (y: yaw, x: pitch, z: roll). (0,0,0) means no rotation
+        const glm::vec3& getEulerRotation() const { return eulerRotation; }
+        // Sets the rotation from euler angles (y: yaw, x: pitch, z: roll)
+        void setEulerRotation(const glm::vec3& euler);
+        // Returns the rotation as a quaternion
+        const glm::quat& getRotation() const { return rotation; }
+        // Sets the rotation from a quaternion (the euler angles are extracted from it)
+        void setRotation(const glm::quat& quaternion);
+
+        // The directions of the local axes relative to the parent (they are not scaled)
+        glm::vec3 getRight() const { return basis[0]; }
+        glm::vec3 getUp() const { return basis[1]; }
+        glm::vec3 getForward() const { return -basis[2]; } // The forward direction is -Z
+
         // This function computes and returns a matrix that represents this transform
         glm::mat4 toMat4() const;
+        // This function computes and returns the affine part of the matrix (the last row is always (0,0,0,1))
+        glm::mat4x3 toAffine() const;
          // Deserializes the entity data and components from a json object
         void deserialize(const nlohmann::json&);
+
+    private:
+        glm::vec3 eulerRotation = glm::vec3(0, 0, 0);
+        glm::quat rotation = glm::quat(1, 0, 0, 0);
+        glm::mat3 basis = glm::mat3(1.0f); // The rotation matrix whose columns are the right, up & backward directions
     };
 
-}
\ No newline at end of file
+}
@@ -1,15 +1,24 @@
 #include "world.hpp"
+#include "prefab.hpp"
+#include "../asset-loader.hpp"
 
 namespace our {
 
     // This will deserialize a json array of entities and add the new entities to the current world
     // If parent pointer is not null, the new entities will be have their parent set to that given pointer
     // If any of the entities has children, this function will be called recursively for these children
+    // If an entity has a "prefab" name, it starts as a copy of that prefab and the rest of its data overrides the copy
+    // (e.g. its position, rotation and scale replace the ones of the prefab root and its components are added to the copy)
     void World::deserialize(const nlohmann::json& data, Entity* parent) {
         if (!data.is_array()) return;
         for (const auto& entityData : data) {
-            Entity* e = add();                 // create and insert into this world
-            e->parent = parent;                // set parent (may be nullptr)
+            Entity* e;
+            if (Prefab* prefab = entityData.contains("prefab") ? AssetLoader<Prefab>::get(entityData["prefab"].get<std::string>()) : nullptr) {
+                e = prefab->instantiate(this, parent); // copy the prefab, then the entity data below overrides its root
+            } else {
+                e = add();                     // create and insert into this world
+                e->setParent(parent);          // set parent (may be nullptr)
+            }
             e->deserialize(entityData);        // fill entity data & components
 
             if (entityData.contains("children")) {
@@ -20,4 +29,16 @@ namespace our {
         }
     }
 
-}
\ No newline at end of file
+    Entity* World::instantiate(const Entity* source, Entity* parent) {
+        Entity* e = add();
+        e->setParent(parent);
+        e->name = source->name;
+        e->localTransform = source->localTransform;
+        e->cloneComponents(source);
+        for (const Entity* child : source->children) {
+            instantiate(child, e);
+        }
+        return e;
+    }
+
+}
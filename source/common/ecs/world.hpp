@@ -1,15 +1,89 @@
 #pragma once
 
-#include <unordered_set>
+#include <memory>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <stdexcept>
 #include "entity.hpp"
+#include "component-storage.hpp"
+#include "object-pool.hpp"
 
 namespace our {
 
+    // A query over the entities that have all the components of the given types (see World::view)
+    template<typename First, typename... Rest>
+    class View {
+        World* world;
+    public:
+        explicit View(World* world) : world(world) {}
+
+        // Calls the given function as "function(entity, first, rest...)" for every matching entity
+        template<typename Function>
+        void forEach(Function&& function);
+    };
+
+    // The type of the functions that are called with the entities right before they are deleted
+    using RemovalListener = std::function<void(const std::vector<Entity*>&)>;
+
     // This class holds a set of entities
+    // The entities are kept in a packed array and their components are kept in contiguous storages (one per component type)
+    // so iterating over the entities or over the components of a type walks over packed memory
     class World {
-        std::unordered_set<Entity*> entities; // These are the entities held by this world
-        std::unordered_set<Entity*> markedForRemoval; // These are the entities that are awaiting to be deleted
-                                                      // when deleteMarkedEntities is called
+        ObjectPool<Entity> entityPool; // The memory of the entities held by this world
+        std::vector<Entity*> entities; // These are the entities held by this world
+        std::vector<Entity*> removalQueue; // These are the entities that are awaiting to be deleted
+                                           // when deleteMarkedEntities is called
+
+        // The slot table that resolves entity handles. A slot keeps its generation after its entity is removed,
+        // and the generation is incremented so that the handles of the removed entity no longer match.
+        struct EntitySlot {
+            Entity* entity = nullptr;
+            std::uint32_t generation = 0;
+        };
+        std::vector<EntitySlot> slots;
+        std::vector<std::uint32_t> freeSlots; // The indices of the slots that have no entity
+
+        // The functions that are called with the entities right before they are deleted
+        std::vector<std::pair<size_t, RemovalListener>> removalListeners;
+        size_t nextRemovalListenerId = 1;
+        // The component storages of this world (one per component type) indexed by the component type ID
+        std::vector<std::unique_ptr<ComponentStorageBase>> storages;
+        // The entities whose transforms changed since the last transform update (their descendants are dirty too)
+        std::vector<Entity*> dirtyTransforms;
+        size_t dirtyTransformCount = 0; // The number of entities marked dirty since the last transform update
+        size_t hierarchyVersion = 0;    // Changes whenever an entity is added, removed or reparented
+
+        friend Entity;
+        friend class TransformSystem;
+
+        // Frees the slot of the entity so that its handles become invalid
+        // A slot whose generation would wrap around is retired instead of reused, otherwise an old handle
+        // could match the entity that gets the slot after the generation comes back to its value.
+        void releaseSlot(Entity* entity) {
+            EntitySlot& slot = slots[entity->handle.getIndex()];
+            slot.entity = nullptr;
+            if (slot.generation >= EntityHandle::MAX_GENERATION) return;
+            ++slot.generation;
+            freeSlots.push_back(entity->handle.getIndex());
+        }
+
+        // Calls the removal listeners with the given entities
+        void notifyRemoval(const std::vector<Entity*>& removed) {
+            if (removed.empty()) return;
+            for (auto& [id, listener] : removalListeners) listener(removed);
+        }
+
+        // Removes the entity from the entities array by moving the last entity into its place
+        void removeFromEntities(Entity* entity) {
+            size_t index = entity->worldIndex;
+            if (index >= entities.size() || entities[index] != entity) return;
+            entities[index] = entities.back();
+            entities[index]->worldIndex = index;
+            entities.pop_back();
+        }
     public:
 
         World() = default;
@@ -19,54 +93,158 @@ namespace our {
         // If any of the entities has children, this function will be called recursively for these children
         void deserialize(const nlohmann::json& data, Entity* parent = nullptr);
 
+        // This creates a copy of the given entity and its descendants (which can belong to another world) and returns the copy
+        // The components are copy constructed directly into the storages of this world, so nothing is deserialized again.
+        // If parent pointer is not null, the copy will have its parent set to that given pointer
+        Entity* instantiate(const Entity* source, Entity* parent = nullptr);
+
         // This adds an entity to the entities set and returns a pointer to that entity
         // WARNING The entity is owned by this world so don't use "delete" to delete it, instead, call "markForRemoval"
-        // to put it in the "markedForRemoval" set. The elements in the "markedForRemoval" set will be removed and
+        // to put it in the removal queue. The entities in the removal queue will be removed and
         // deleted when "deleteMarkedEntities" is called.
-        Entity* World::add() {
-            Entity* e = new Entity();
+        // To keep a reference to an entity that may be removed, keep its handle (see "getHandle") instead of the pointer.
+        Entity* add() {
+            // The handles can't address more slots than their index bits allow
+            if (freeSlots.empty() && slots.size() > EntityHandle::INDEX_MASK) {
+                throw std::length_error("World: ran out of entity slots");
+            }
+            auto [e, poolIndex] = entityPool.emplace();
             e->world = this;
-            e->parent = nullptr;
-            // insert into entities set
-            entities.insert(e);
+            e->poolIndex = poolIndex;
+            // give it a slot in the slot table
+            std::uint32_t slotIndex;
+            if (!freeSlots.empty()) {
+                slotIndex = freeSlots.back();
+                freeSlots.pop_back();
+            } else {
+                slotIndex = (std::uint32_t)slots.size();
+                slots.emplace_back();
+            }
+            slots[slotIndex].entity = e;
+            e->handle = EntityHandle(slotIndex, slots[slotIndex].generation);
+            // append to the entities array
+            e->worldIndex = entities.size();
+            entities.push_back(e);
+            // The new entity has no cached matrix yet
+            dirtyTransforms.push_back(e);
+            ++dirtyTransformCount;
+            ++hierarchyVersion;
             return e;
         }
 
-        // This returns and immutable reference to the set of all entites in the world.
-        const std::unordered_set<Entity*>& getEntities() {
+        // Returns the entity referred to by the given handle, or nullptr if the entity was removed (or the handle is null)
+        Entity* get(EntityHandle handle) const {
+            if (handle.isNull() || handle.getIndex() >= slots.size()) return nullptr;
+            const EntitySlot& slot = slots[handle.getIndex()];
+            return slot.generation == handle.getGeneration() ? slot.entity : nullptr;
+        }
+
+        // Returns true if the entity referred to by the given handle still exists
+        bool isAlive(EntityHandle handle) const { return get(handle) != nullptr; }
+
+        // This returns and immutable reference to the array of all entites in the world.
+        const std::vector<Entity*>& getEntities() {
             return entities;
         }
 
-        // This marks an entity for removal by adding it to the "markedForRemoval" set.
-        // The elements in the "markedForRemoval" set will be removed and deleted when "deleteMarkedEntities" is called.
+        // This returns the storage that holds all the components of type T in this world (and creates it if it doesn't exist)
+        template<typename T>
+        ComponentStorage<T>& getStorage() {
+            ComponentTypeID type = getComponentTypeID<T>();
+            if (type >= storages.size()) storages.resize(type + 1);
+            auto& storage = storages[type];
+            if (!storage) storage = std::make_unique<ComponentStorage<T>>();
+            return static_cast<ComponentStorage<T>&>(*storage);
+        }
+
+        // This calls the given function for every component of type T in this world
+        // It is faster than going through the entities and searching their components since it walks over the packed storage
+        // It doesn't create the storage if it doesn't exist, so systems running in parallel can call it safely
+        template<typename T, typename Function>
+        void forEach(Function&& function) {
+            ComponentTypeID type = getComponentTypeID<T>();
+            if (type >= storages.size() || !storages[type]) return;
+            static_cast<ComponentStorage<T>&>(*storages[type]).forEach(std::forward<Function>(function));
+        }
+
+        // This returns a view over the entities that have all the components of the given types
+        // Calling "forEach" on the view calls the given function with the entity and a pointer to each of its components:
+        //      world->view<CameraComponent, FreeCameraControllerComponent>().forEach(
+        //          [](Entity* entity, CameraComponent* camera, FreeCameraControllerComponent* controller){ ... });
+        // The view walks over the storage of the first type and looks up the others in each owner,
+        // so put the rarest component type first.
+        template<typename First, typename... Rest>
+        View<First, Rest...> view() {
+            return View<First, Rest...>(this);
+        }
+
+        // Adds a function that is called with every batch of entities right before they are deleted
+        // (by "deleteMarkedEntities" or "clear"), so systems can release what they hold for these entities in one sweep.
+        // Returns an id to pass to "removeRemovalListener".
+        size_t addRemovalListener(RemovalListener listener) {
+            size_t id = nextRemovalListenerId++;
+            removalListeners.emplace_back(id, std::move(listener));
+            return id;
+        }
+        void removeRemovalListener(size_t id) {
+            removalListeners.erase(std::remove_if(removalListeners.begin(), removalListeners.end(),
+                [id](const auto& entry){ return entry.first == id; }), removalListeners.end());
+        }
+
+        // This marks an entity and its descendants for removal by adding them to the removal queue.
+        // The entities in the removal queue will be removed and deleted when "deleteMarkedEntities" is called.
         void markForRemoval(Entity* entity) {
-            if (entity == nullptr) return;
-            if (entities.find(entity) != entities.end()) {
-                markedForRemoval.insert(entity);
-            }
+            if (entity == nullptr || entity->world != this || entity->markedForRemoval) return;
+            entity->markedForRemoval = true;
+            removalQueue.push_back(entity);
+            for (Entity* child : entity->children) markForRemoval(child);
+        }
+        void markForRemoval(EntityHandle handle) {
+            markForRemoval(get(handle));
         }
 
-        // This removes the elements in "markedForRemoval" from the "entities" set.
-        // Then each of these elements are deleted.
+        // This removes the entities in the removal queue from the "entities" array.
+        // The removal listeners are notified with the whole batch, then the entities are deleted.
         void deleteMarkedEntities() {
-            for (Entity* e : markedForRemoval) {
-                // remove from entities set if present
-                auto it = entities.find(e);
-                if (it != entities.end()) entities.erase(it);
-                delete e;
+            if (removalQueue.empty()) return;
+            notifyRemoval(removalQueue);
+            // Remove the deleted entities from the dirty list and from the children of the remaining parents
+            dirtyTransforms.erase(std::remove_if(dirtyTransforms.begin(), dirtyTransforms.end(),
+                [](Entity* e){ return e->markedForRemoval; }), dirtyTransforms.end());
+            for (Entity* e : removalQueue) {
+                if (e->parent && !e->parent->markedForRemoval) {
+                    auto& siblings = e->parent->children;
+                    siblings.erase(std::remove(siblings.begin(), siblings.end(), e), siblings.end());
+                }
             }
-            markedForRemoval.clear();
+            for (Entity* e : removalQueue) {
+                removeFromEntities(e);
+                releaseSlot(e);
+                entityPool.destroyAt(e->poolIndex);
+            }
+            removalQueue.clear();
+            ++hierarchyVersion;
         }
 
         //This deletes all entities in the world
         void clear(){
-            // delete all entities
+            notifyRemoval(entities);
+            // Destroy all the components and the entities in bulk. The pools keep their memory, so rebuilding the world
+            // (e.g. when the state is entered again) reuses it instead of going back to the allocator.
+            for (auto& storage : storages) {
+                if (storage) storage->clear();
+            }
             for (Entity* e : entities) {
-                delete e;
+                e->components.clear(); // The components are already destroyed
+                releaseSlot(e);
             }
+            entityPool.clear();
             entities.clear();
-            // ensure marked set cleared too
-            markedForRemoval.clear();
+            // ensure removal queue and dirty list cleared too
+            removalQueue.clear();
+            dirtyTransforms.clear();
+            dirtyTransformCount = 0;
+            ++hierarchyVersion;
         }
 
         //Since the world owns all of its entities, they should be deleted alongside it.
@@ -79,4 +257,31 @@ namespace our {
         World &operator=(World const &) = delete;
     };
 
-}
\ No newline at end of file
+    // This template method create a component of type T in the component storage of the world,
+    // adds it to the components list and returns a pointer to it
+    template<typename T>
+    T* Entity::addComponent(){
+        static_assert(std::is_base_of<Component, T>::value, "T must inherit from Component");
+        //TODO: (Req 8) Create an component of type T, set its "owner" to be this entity, then push it into the component's list
+        // Don't forget to return a pointer to the new component
+        ComponentStorage<T>& storage = world->getStorage<T>();
+        auto [component, slot] = storage.emplace();
+        component->owner = this;
+        components.push_back({component, &storage, slot, getComponentTypeID<T>()});
+        return component;
+    }
+
+    template<typename First, typename... Rest>
+    template<typename Function>
+    void View<First, Rest...>::forEach(Function&& function) {
+        world->forEach<First>([&](First* first){
+            Entity* entity = first->getOwner();
+            // Look up the other components and skip the entity if any of them is missing
+            std::tuple<Rest*...> rest(entity->getComponent<Rest>()...);
+            bool matched = std::apply([](auto*... components){ return ((components != nullptr) && ...); }, rest);
+            if(!matched) return;
+            std::apply([&](auto*... components){ function(entity, first, components...); }, rest);
+        });
+    }
+
+}
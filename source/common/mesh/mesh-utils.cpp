@@ -7,6 +7,7 @@
 #include <iostream>
 #include <vector>
 #include <unordered_map>
+#include <glm/gtc/constants.hpp>
 
 our::Mesh* our::mesh_utils::loadOBJ(const std::string& filename) {
 
@@ -152,6 +153,9 @@ our::Mesh* our::mesh_utils::loadOBJ(const std::string& filename) {
     mesh->getElementCount() = elements.size();
     glBindVertexArray(0);
 
+    // Keep a CPU copy of the elements (used for simplification and physics)
+    mesh->elements = elements;
+
     return mesh;
 }
 
@@ -192,4 +196,123 @@ our::Mesh* our::mesh_utils::sphere(const glm::ivec2& segments){
     }
 
     return new our::Mesh(vertices, elements);
-}
\ No newline at end of file
+}
+
+// Create a simplified copy of the mesh using vertex clustering
+our::Mesh* our::mesh_utils::simplify(const our::Mesh& mesh, int resolution){
+    if(mesh.vertices.empty() || mesh.elements.empty()){
+        std::cerr << "Can't simplify a mesh without CPU vertices and elements" << std::endl;
+        return nullptr;
+    }
+
+    // The size of a grid cell is picked such that the longest side of the bounding box has "resolution" cells
+    glm::vec3 extent = mesh.boundsMax - mesh.boundsMin;
+    float cellSize = glm::max(glm::max(extent.x, extent.y), extent.z) / glm::max(resolution, 1);
+    if(cellSize <= 0.0f) cellSize = 1.0f;
+
+    // Each vertex is assigned to the cluster of its grid cell
+    // The cluster position and normal are the averages of its vertices while the rest of the attributes come from its first vertex
+    std::vector<our::Vertex> vertices;
+    std::vector<int> clusterSizes;
+    std::vector<GLuint> remap(mesh.vertices.size());
+    std::unordered_map<uint64_t, GLuint> cluster_map;
+    for(size_t index = 0; index < mesh.vertices.size(); ++index){
+        const our::Vertex& vertex = mesh.vertices[index];
+        glm::u64vec3 cell = glm::u64vec3(glm::max((vertex.position - mesh.boundsMin) / cellSize, glm::vec3(0.0f)));
+        uint64_t key = cell.x | (cell.y << 21) | (cell.z << 42);
+        auto it = cluster_map.find(key);
+        if(it == cluster_map.end()){
+            GLuint cluster = vertices.size();
+            cluster_map[key] = cluster;
+            vertices.push_back(vertex);
+            clusterSizes.push_back(1);
+            remap[index] = cluster;
+        } else {
+            our::Vertex& merged = vertices[it->second];
+            merged.position += vertex.position;
+            merged.normal += vertex.normal;
+            clusterSizes[it->second]++;
+            remap[index] = it->second;
+        }
+    }
+    for(size_t cluster = 0; cluster < vertices.size(); ++cluster){
+        vertices[cluster].position /= (float)clusterSizes[cluster];
+        float length = glm::length(vertices[cluster].normal);
+        if(length > 0.0f) vertices[cluster].normal /= length;
+    }
+
+    // Remap the triangles of each submesh (or the whole mesh if it has no submeshes) and drop the collapsed ones
+    std::vector<our::Mesh::Submesh> sources = mesh.submeshes;
+    if(sources.empty()) sources.push_back({0, (GLuint)mesh.elements.size(), ""});
+    std::vector<GLuint> elements;
+    std::vector<our::Mesh::Submesh> submeshes;
+    for(const auto& source : sources){
+        our::Mesh::Submesh submesh = { (GLuint)elements.size(), 0, source.materialName };
+        GLuint end = glm::min(source.offset + source.count, (GLuint)mesh.elements.size());
+        for(GLuint i = source.offset; i + 2 < end; i += 3){
+            GLuint a = remap[mesh.elements[i]], b = remap[mesh.elements[i + 1]], c = remap[mesh.elements[i + 2]];
+            if(a == b || b == c || c == a) continue;
+            elements.push_back(a);
+            elements.push_back(b);
+            elements.push_back(c);
+        }
+        submesh.count = elements.size() - submesh.offset;
+        if(submesh.count > 0) submeshes.push_back(submesh);
+    }
+
+    our::Mesh* simplified = new our::Mesh(vertices, elements);
+    // A mesh without submeshes is drawn with its own material, so we only keep the submeshes if the source had them
+    if(!mesh.submeshes.empty()) simplified->submeshes = submeshes;
+    return simplified;
+}
+
+// Pick a bounded number of points on the convex hull of the mesh
+std::vector<glm::vec3> our::mesh_utils::convexHullPoints(const our::Mesh& mesh, int maxPoints){
+    // Remove the duplicated positions (the vertices are duplicated for each normal and texture coordinate)
+    std::vector<glm::vec3> positions;
+    std::unordered_map<glm::vec3, size_t> seen;
+    for(const auto& vertex : mesh.vertices){
+        if(seen.emplace(vertex.position, positions.size()).second) positions.push_back(vertex.position);
+    }
+    return convexHullPoints(positions, maxPoints);
+}
+
+// Pick a bounded number of points on the convex hull of the given points
+std::vector<glm::vec3> our::mesh_utils::convexHullPoints(const std::vector<glm::vec3>& positions, int maxPoints){
+    if(positions.size() <= static_cast<size_t>(maxPoints)) return positions;
+
+    // Every point returned is the farthest vertex along one direction (the support point), so it lies on the hull.
+    // The directions are spread evenly over the sphere (a Fibonacci lattice) starting with the 6 axis directions
+    // so the bounding box of the hull is kept exact. More directions than points are tried since some share a point.
+    std::vector<glm::vec3> directions = {
+        {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+    };
+    int sampleCount = 4 * maxPoints;
+    float goldenAngle = glm::pi<float>() * (3.0f - glm::sqrt(5.0f));
+    for(int sample = 0; sample < sampleCount; ++sample){
+        float y = 1.0f - 2.0f * (sample + 0.5f) / sampleCount;
+        float radius = glm::sqrt(1.0f - y * y);
+        float angle = goldenAngle * sample;
+        directions.push_back({radius * glm::cos(angle), y, radius * glm::sin(angle)});
+    }
+
+    std::vector<glm::vec3> points;
+    std::vector<bool> picked(positions.size(), false);
+    for(const auto& direction : directions){
+        if(points.size() >= static_cast<size_t>(maxPoints)) break;
+        size_t best = 0;
+        float bestDistance = glm::dot(positions[0], direction);
+        for(size_t index = 1; index < positions.size(); ++index){
+            float distance = glm::dot(positions[index], direction);
+            if(distance > bestDistance){
+                bestDistance = distance;
+                best = index;
+            }
+        }
+        if(!picked[best]){
+            picked[best] = true;
+            points.push_back(positions[best]);
+        }
+    }
+    return points;
+}
@@ -2,6 +2,7 @@
 
 #include "mesh.hpp"
 #include <string>
+#include <vector>
 
 namespace our::mesh_utils {
     // Load an ".obj" file into the mesh
@@ -9,4 +10,13 @@ namespace our::mesh_utils {
     // Create a sphere (the vertex order in the triangles are CCW from the outside)
     // Segments define the number of divisions on the both the latitude and the longitude
     Mesh* sphere(const glm::ivec2& segments);
+    // Create a simplified copy of the mesh using vertex clustering (useful for generating levels of detail)
+    // The bounding box is divided into a grid with "resolution" cells along its longest side and the vertices in each cell are merged
+    // The submeshes are kept while the triangles that collapse are removed
+    Mesh* simplify(const Mesh& mesh, int resolution);
+    // Pick at most "maxPoints" vertices of the mesh that lie on its convex hull (used to build cheap convex collision shapes)
+    // If the mesh has more distinct vertices than that, the farthest vertices along evenly spread directions are picked
+    std::vector<glm::vec3> convexHullPoints(const Mesh& mesh, int maxPoints);
+    // The same as above for a list of distinct points
+    std::vector<glm::vec3> convexHullPoints(const std::vector<glm::vec3>& positions, int maxPoints);
 }
\ No newline at end of file
@@ -31,6 +31,22 @@ namespace our {
         // Only ONE declaration
         std::vector<Submesh> submeshes;
 
+        // The axis aligned bounding box of the vertices in the local space (used for culling)
+        glm::vec3 boundsMin = glm::vec3(0.0f), boundsMax = glm::vec3(0.0f);
+
+        // A coarser version of this mesh and the projected size (the diameter relative to the screen height) below which it is used
+        struct LevelOfDetail {
+            Mesh* mesh;
+            float screenSize;
+        };
+        // The coarser levels of detail ordered from the finest to the coarsest (this mesh is level 0)
+        // The meshes of the levels are owned by this mesh
+        std::vector<LevelOfDetail> lods;
+
+        // The bounding sphere around the bounding box (used for picking the level of detail)
+        glm::vec3 getBoundingCenter() const { return (boundsMin + boundsMax) * 0.5f; }
+        float getBoundingRadius() const { return glm::length(boundsMax - boundsMin) * 0.5f; }
+
         unsigned int getVAO() const { return VAO; }
         unsigned int getEBO() const { return EBO; }
         GLsizei& getElementCount() { return elementCount; }
@@ -39,6 +55,13 @@ namespace our {
             : vertices(vertices), elements(elements)
         {
             elementCount = static_cast<GLsizei>(elements.size());
+            if(!vertices.empty()){
+                boundsMin = boundsMax = vertices[0].position;
+                for(const auto& vertex : vertices){
+                    boundsMin = glm::min(boundsMin, vertex.position);
+                    boundsMax = glm::max(boundsMax, vertex.position);
+                }
+            }
             glGenVertexArrays(1, &VAO);
             glGenBuffers(1, &VBO);
             glGenBuffers(1, &EBO);
@@ -74,6 +97,7 @@ namespace our {
         }
 
         ~Mesh() {
+            for(auto& lod : lods) delete lod.mesh;
             glDeleteVertexArrays(1, &VAO);
             glDeleteBuffers(1, &VBO);
             glDeleteBuffers(1, &EBO);
@@ -9,18 +9,43 @@
 std::string checkForShaderCompilationErrors(GLuint shader);
 std::string checkForLinkingErrors(GLuint program);
 
-bool our::ShaderProgram::attach(const std::string& filename, GLenum type) const {
-    std::cout << "Attaching shader: " << filename << " type=" << type << std::endl;
-
+// Reads the shader file and replaces each line of the form: #include "file" by the content of that file
+// (relative to the directory of the including file), so the shaders can share their common functions
+static bool loadShaderSource(const std::string& filename, std::string& source, int depth = 0) {
     std::ifstream file(filename);
     if (!file) {
         std::cerr << "ERROR: Couldn't open shader file: " << filename << std::endl;
         return false;
     }
+    if (depth > 8) {
+        std::cerr << "ERROR: Shader includes are nested too deeply in: " << filename << std::endl;
+        return false;
+    }
+    std::string directory = filename.substr(0, filename.find_last_of("/\\") + 1);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t start = line.find_first_not_of(" \t");
+        if (start != std::string::npos && line.compare(start, 8, "#include") == 0) {
+            size_t open = line.find('"', start), close = line.rfind('"');
+            if (open == std::string::npos || close <= open) {
+                std::cerr << "ERROR: Invalid include in shader file: " << filename << std::endl;
+                return false;
+            }
+            if (!loadShaderSource(directory + line.substr(open + 1, close - open - 1), source, depth + 1)) return false;
+        } else {
+            source += line;
+            source += '\n';
+        }
+    }
+    return true;
+}
+
+bool our::ShaderProgram::attach(const std::string& filename, GLenum type) const {
+    std::cout << "Attaching shader: " << filename << " type=" << type << std::endl;
 
-    std::string sourceString = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    std::string sourceString;
+    if (!loadShaderSource(filename, sourceString)) return false;
     const char* sourceCStr = sourceString.c_str();
-    file.close();
 
 
     GLuint shader = glCreateShader(type);
@@ -54,6 +79,8 @@ bool our::ShaderProgram::link() const {
         std::cerr << "ERROR: Shader linking failed:\n" << error << std::endl;
         return false;
     }
+    // Look up once whether the shader can write to the OIT targets (see "assets/shaders/oit.glsl")
+    oitSupported = glGetUniformLocation(program, "oit") != -1;
     std::cout << "Shader linked successfully! Program ID: " << program << std::endl;
     return true;
     
@@ -15,6 +15,8 @@ namespace our {
     private:
         //Shader Program Handle (OpenGL object name)
         GLuint program;
+        // Whether the program has an "oit" uniform (it is found when the program is linked)
+        mutable bool oitSupported = false;
 
     public:
         ShaderProgram() {
@@ -37,6 +39,9 @@ namespace our {
 
         }
 
+        // Returns true if the shader can be drawn in the weighted blended OIT pass of the renderer
+        bool supportsOIT() const { return oitSupported; }
+
         GLuint getUniformLocation(const std::string& name) {
             //TODO: (Req 1) Return the location of the uniform with the given name
             return glGetUniformLocation(program, name.c_str());
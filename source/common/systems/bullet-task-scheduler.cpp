@@ -0,0 +1,38 @@
+#include "bullet-task-scheduler.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace our {
+
+    BulletTaskScheduler::BulletTaskScheduler(ThreadPool* pool) : btITaskScheduler("ThreadPool"), pool(pool) {}
+
+    int BulletTaskScheduler::getMaxNumThreads() const {
+        return BT_MAX_THREAD_COUNT;
+    }
+
+    int BulletTaskScheduler::getNumThreads() const {
+        // The thread that calls "parallelFor" works too
+        return std::min(static_cast<int>(pool->getWorkerCount()) + 1, BT_MAX_THREAD_COUNT);
+    }
+
+    void BulletTaskScheduler::parallelFor(int begin, int end, int grainSize, const btIParallelForBody& body) {
+        if(begin >= end) return;
+        pool->parallelFor(begin, end, std::max(grainSize, 1), [&body](size_t first, size_t last){
+            body.forLoop(static_cast<int>(first), static_cast<int>(last));
+        });
+    }
+
+    btScalar BulletTaskScheduler::parallelSum(int begin, int end, int grainSize, const btIParallelSumBody& body) {
+        if(begin >= end) return btScalar(0);
+        std::mutex mutex;
+        btScalar sum = btScalar(0);
+        pool->parallelFor(begin, end, std::max(grainSize, 1), [&](size_t first, size_t last){
+            btScalar partial = body.sumLoop(static_cast<int>(first), static_cast<int>(last));
+            std::lock_guard<std::mutex> lock(mutex);
+            sum += partial;
+        });
+        return sum;
+    }
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "../threading/thread-pool.hpp"
+
+#include <LinearMath/btThreads.h>
+
+namespace our {
+
+    // This lets Bullet's multithreaded dynamics world run its parallel loops on our thread pool
+    // instead of starting its own threads that would compete with the pool for the cores.
+    // It is installed with "btSetTaskScheduler" by the physics system when multithreading is enabled.
+    class BulletTaskScheduler : public btITaskScheduler {
+        ThreadPool* pool;
+    public:
+        explicit BulletTaskScheduler(ThreadPool* pool = &ThreadPool::getShared());
+
+        int getMaxNumThreads() const override;
+        int getNumThreads() const override;
+        // The number of threads is decided by the pool, so this is ignored
+        void setNumThreads(int /*numThreads*/) override {}
+
+        void parallelFor(int begin, int end, int grainSize, const btIParallelForBody& body) override;
+        btScalar parallelSum(int begin, int end, int grainSize, const btIParallelSumBody& body) override;
+    };
+
+}
@@ -0,0 +1,113 @@
+#include "bvh-cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    // Every cache file starts with this header followed by the serialized BVH
+    // The BVH is serialized in Bullet's in-memory layout, so the header records the build it was written by
+    // and the files of a different Bullet version, scalar precision or pointer size are rebuilt instead of loaded
+    struct Header {
+        char magic[4] = {'B', 'V', 'H', '2'};
+        std::uint32_t bulletVersion = BT_BULLET_VERSION;
+        std::uint32_t scalarSize = sizeof(btScalar);
+        std::uint32_t pointerSize = sizeof(void*);
+        std::uint32_t triangleCount = 0;
+        std::uint32_t size = 0;         // The size of the serialized BVH in bytes
+        std::uint32_t reserved[2] = {}; // Keeps the BVH data 16-byte aligned in the file
+    };
+
+    std::string cacheDirectory = "assets/cache/bvh";
+}
+
+void our::bvh_cache::setDirectory(const std::string& directory) {
+    cacheDirectory = directory;
+}
+
+const std::string& our::bvh_cache::getDirectory() {
+    return cacheDirectory;
+}
+
+std::string our::bvh_cache::getPath(std::uint64_t hash) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bvh", static_cast<unsigned long long>(hash));
+    return (std::filesystem::path(cacheDirectory) / name).string();
+}
+
+btOptimizedBvh* our::bvh_cache::load(std::uint64_t hash, int triangleCount, void*& buffer) {
+    buffer = nullptr;
+    std::ifstream file(getPath(hash), std::ios::binary | std::ios::ate);
+    if(!file) return nullptr;
+    std::streamoff fileSize = file.tellg();
+    file.seekg(0);
+
+    // The header is checked before anything is allocated, so a corrupt or stale file is rebuilt instead of trusted
+    Header header, expected;
+    if(fileSize < static_cast<std::streamoff>(sizeof(header))) return nullptr;
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return nullptr;
+    if(!std::equal(header.magic, header.magic + 4, expected.magic) ||
+        header.bulletVersion != expected.bulletVersion || header.scalarSize != expected.scalarSize ||
+        header.pointerSize != expected.pointerSize ||
+        header.triangleCount != static_cast<std::uint32_t>(triangleCount)) return nullptr;
+    if(static_cast<std::streamoff>(header.size) != fileSize - static_cast<std::streamoff>(sizeof(header)) ||
+        header.size < sizeof(btOptimizedBvh)) return nullptr;
+
+    // Bullet requires the buffer of an in-place BVH to be 16-byte aligned
+    buffer = btAlignedAlloc(header.size, 16);
+    if(!file.read(static_cast<char*>(buffer), header.size)){
+        btAlignedFree(buffer);
+        buffer = nullptr;
+        return nullptr;
+    }
+    // The node counts in the serialized BVH must fit in the buffer too. Bullet checks this with an assert
+    // (which aborts debug builds), so it is checked here first the same way "deSerializeInPlace" computes it
+    // The BVH is written in the byte order of this machine, so no endian swap is needed
+    btOptimizedBvh* bvh = nullptr;
+    if(static_cast<const btOptimizedBvh*>(buffer)->calculateSerializeBufferSize() <= header.size){
+        bvh = btOptimizedBvh::deSerializeInPlace(buffer, header.size, false);
+    }
+    if(!bvh){
+        btAlignedFree(buffer);
+        buffer = nullptr;
+    }
+    return bvh;
+}
+
+bool our::bvh_cache::save(std::uint64_t hash, int triangleCount, const btOptimizedBvh* bvh) {
+    if(!bvh) return false;
+    std::string path = getPath(hash);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+    if(ec) return false;
+
+    Header header;
+    header.triangleCount = static_cast<std::uint32_t>(triangleCount);
+    header.size = bvh->calculateSerializeBufferSize();
+    void* buffer = btAlignedAlloc(header.size, 16);
+    bool serialized = bvh->serializeInPlace(buffer, header.size, false);
+    bool written = false;
+    if(serialized){
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(static_cast<const char*>(buffer), header.size);
+        written = static_cast<bool>(file);
+    }
+    btAlignedFree(buffer);
+    if(!written){
+        std::cerr << "Failed to write the BVH cache: " << path << std::endl;
+        std::filesystem::remove(path, ec);
+    }
+    return written;
+}
+
+std::uint64_t our::bvh_cache::hashBytes(const void* data, size_t size, std::uint64_t hash) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for(size_t index = 0; index < size; ++index){
+        hash ^= bytes[index];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
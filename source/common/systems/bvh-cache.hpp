@@ -0,0 +1,26 @@
+#pragma once
+
+#include <btBulletDynamicsCommon.h>
+
+#include <cstdint>
+#include <string>
+
+namespace our::bvh_cache {
+    // The directory in which the built BVHs of the triangle mesh colliders are saved (default: "assets/cache/bvh")
+    void setDirectory(const std::string& directory);
+    const std::string& getDirectory();
+
+    // Returns the path of the cached BVH for the given content hash
+    std::string getPath(std::uint64_t hash);
+
+    // Loads the BVH saved for the given content hash with Bullet's in-place deserialization.
+    // The BVH lives inside "buffer" which must be kept alive while the BVH is used and freed with "btAlignedFree" afterwards.
+    // Returns nullptr if there is no valid cached BVH built from the same number of triangles.
+    btOptimizedBvh* load(std::uint64_t hash, int triangleCount, void*& buffer);
+
+    // Saves the given (quantized) BVH for the given content hash. Returns false if the file couldn't be written.
+    bool save(std::uint64_t hash, int triangleCount, const btOptimizedBvh* bvh);
+
+    // Combines the given bytes into a 64-bit FNV-1a hash (pass the previous result to hash more data)
+    std::uint64_t hashBytes(const void* data, size_t size, std::uint64_t hash = 14695981039346656037ull);
+}
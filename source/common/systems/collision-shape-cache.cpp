@@ -0,0 +1,55 @@
+#include "collision-shape-cache.hpp"
+
+#include <algorithm>
+
+namespace our {
+
+    size_t CollisionShapeKeyHash::operator()(const CollisionShapeKey& key) const {
+        // Combine the bytes of the fields with FNV-1a
+        size_t hash = 14695981039346656037ull;
+        auto combine = [&hash](const void* data, size_t length){
+            const unsigned char* bytes = static_cast<const unsigned char*>(data);
+            for(size_t index = 0; index < length; ++index){
+                hash ^= bytes[index];
+                hash *= 1099511628211ull;
+            }
+        };
+        int type = static_cast<int>(key.type);
+        combine(&type, sizeof(type));
+        combine(&key.size, sizeof(key.size));
+        combine(&key.mesh, sizeof(key.mesh));
+        return hash;
+    }
+
+    std::shared_ptr<btCollisionShape> CollisionShapeCache::get(const CollisionShapeKey& key, const Factory& create) {
+        auto it = shapes.find(key);
+        if(it != shapes.end()){
+            if(auto shape = it->second.lock()) return shape;
+        }
+        // The colliders of removed entities leave expired entries behind (keyed by meshes that may never be used again),
+        // so they are swept here once in a while instead of letting them pile up
+        if(shapes.size() >= purgeThreshold){
+            purge();
+            purgeThreshold = std::max(MIN_PURGE_THRESHOLD, 2 * shapes.size());
+        }
+        // The factory may get other shapes from this cache (the scaled mesh shapes share their triangle mesh),
+        // so the entry is only added after the shape is created
+        std::shared_ptr<btCollisionShape> shape = create();
+        shapes[key] = shape;
+        return shape;
+    }
+
+    void CollisionShapeCache::purge() {
+        for(auto it = shapes.begin(); it != shapes.end();){
+            if(it->second.expired()) it = shapes.erase(it);
+            else ++it;
+        }
+    }
+
+    size_t CollisionShapeCache::size() const {
+        size_t count = 0;
+        for(auto& [key, shape] : shapes) if(!shape.expired()) ++count;
+        return count;
+    }
+
+}
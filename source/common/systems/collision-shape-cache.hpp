@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../components/bullet-collider.hpp"
+
+#include <btBulletDynamicsCommon.h>
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+
+namespace our {
+
+    // The description of a collision shape: colliders with equal keys get the same shape
+    struct CollisionShapeKey {
+        CollisionShape type = CollisionShape::BOX;
+        glm::vec3 size = glm::vec3(0.0f);         // The dimensions of the primitive shapes or the scale of the mesh shapes
+        const Mesh* mesh = nullptr;               // Only used by the mesh and convex hull shapes
+
+        bool operator==(const CollisionShapeKey& other) const {
+            return type == other.type && size == other.size && mesh == other.mesh;
+        }
+    };
+
+    struct CollisionShapeKeyHash {
+        size_t operator()(const CollisionShapeKey& key) const;
+    };
+
+    // This class lets the colliders share their collision shapes.
+    // A crowd of zombies with the same capsule or a room full of the same crate needs only one Bullet shape,
+    // which saves memory and the time spent building the shapes (specially the triangle mesh BVHs).
+    // The colliders own their shapes through shared pointers and the cache only keeps weak pointers,
+    // so a shape is deleted as soon as the last collider using it is destroyed.
+    class CollisionShapeCache {
+    public:
+        // Creates a shape (the shared pointer may have a custom deleter to free the data the shape refers to)
+        using Factory = std::function<std::shared_ptr<btCollisionShape>()>;
+
+        // Returns the cached shape for the given key or creates it with the given factory if there is none
+        // The entries of the shapes that are not used anymore are swept when the cache has doubled since the last sweep
+        std::shared_ptr<btCollisionShape> get(const CollisionShapeKey& key, const Factory& create);
+
+        // Forgets the shapes that are not used anymore
+        void purge();
+
+        // The number of shapes that are currently used by the colliders
+        size_t size() const;
+
+        void clear() { shapes.clear(); purgeThreshold = MIN_PURGE_THRESHOLD; }
+
+    private:
+        static constexpr size_t MIN_PURGE_THRESHOLD = 64;
+        std::unordered_map<CollisionShapeKey, std::weak_ptr<btCollisionShape>, CollisionShapeKeyHash> shapes;
+        size_t purgeThreshold = MIN_PURGE_THRESHOLD;   // The number of entries at which the next sweep happens
+    };
+
+}
@@ -0,0 +1,274 @@
+#include "convex-decomposition.hpp"
+#include "bvh-cache.hpp"
+#include "../mesh/mesh-utils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    using our::convex_decomposition::Parts;
+    using our::convex_decomposition::Settings;
+
+    std::string cacheDirectory = "assets/cache/hulls";
+
+    std::mutex memoryCacheMutex;
+    std::unordered_map<std::uint64_t, Parts> memoryCache;
+
+    // A group of triangles of the mesh with the points of its hull
+    struct Part {
+        std::vector<std::uint32_t> triangles;
+        std::vector<glm::vec3> hull;
+        float concavity = 0.0f;
+        int depth = 0;
+    };
+
+    // The triangle corners of the mesh (only the positions are used)
+    struct Triangles {
+        std::vector<glm::vec3> positions;
+        std::vector<std::uint32_t> indices;
+        glm::vec3 corner(std::uint32_t triangle, int index) const { return positions[indices[3 * triangle + index]]; }
+        glm::vec3 centroid(std::uint32_t triangle) const {
+            return (corner(triangle, 0) + corner(triangle, 1) + corner(triangle, 2)) / 3.0f;
+        }
+    };
+
+    // The number of triangles tested when measuring the concavity of a part (bigger parts are sampled)
+    constexpr size_t CONCAVITY_SAMPLES = 512;
+
+    void evaluate(Part& part, const Triangles& mesh, const Settings& settings, std::vector<std::uint32_t>& stamps, std::uint32_t stamp) {
+        // Gather the distinct vertices of the part
+        std::vector<glm::vec3> points;
+        for(std::uint32_t triangle : part.triangles){
+            for(int index = 0; index < 3; ++index){
+                std::uint32_t vertex = mesh.indices[3 * triangle + index];
+                if(stamps[vertex] == stamp) continue;
+                stamps[vertex] = stamp;
+                points.push_back(mesh.positions[vertex]);
+            }
+        }
+        part.hull = our::mesh_utils::convexHullPoints(points, settings.maxPointsPerPart);
+
+        // A triangle of a convex part lies on the hull, so no hull point is in front of it
+        part.concavity = 0.0f;
+        size_t stride = std::max<size_t>(1, part.triangles.size() / CONCAVITY_SAMPLES);
+        for(size_t sample = 0; sample < part.triangles.size(); sample += stride){
+            std::uint32_t triangle = part.triangles[sample];
+            glm::vec3 a = mesh.corner(triangle, 0);
+            glm::vec3 normal = glm::cross(mesh.corner(triangle, 1) - a, mesh.corner(triangle, 2) - a);
+            float length = glm::length(normal);
+            if(length <= 1e-12f) continue;
+            normal /= length;
+            for(const auto& point : part.hull){
+                part.concavity = std::max(part.concavity, glm::dot(normal, point - a));
+            }
+        }
+    }
+
+    // Splits the part in two halves at the median of the triangle centroids along the longest side of their bounding box
+    bool split(const Part& part, const Triangles& mesh, Part& first, Part& second) {
+        glm::vec3 low(std::numeric_limits<float>::max()), high(-std::numeric_limits<float>::max());
+        for(std::uint32_t triangle : part.triangles){
+            glm::vec3 centroid = mesh.centroid(triangle);
+            low = glm::min(low, centroid);
+            high = glm::max(high, centroid);
+        }
+        glm::vec3 extent = high - low;
+        int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        if(extent[axis] <= 0.0f) return false;
+
+        first.triangles = part.triangles;
+        auto middle = first.triangles.begin() + first.triangles.size() / 2;
+        std::nth_element(first.triangles.begin(), middle, first.triangles.end(), [&](std::uint32_t left, std::uint32_t right){
+            return mesh.centroid(left)[axis] < mesh.centroid(right)[axis];
+        });
+        second.triangles.assign(middle, first.triangles.end());
+        first.triangles.erase(middle, first.triangles.end());
+        first.depth = second.depth = part.depth + 1;
+        return !first.triangles.empty() && !second.triangles.empty();
+    }
+
+    std::uint64_t hashMesh(const our::Mesh& mesh, const Settings& settings) {
+        std::uint64_t hash = our::bvh_cache::hashBytes(&settings, sizeof(settings));
+        hash = our::bvh_cache::hashBytes(mesh.elements.data(), mesh.elements.size() * sizeof(unsigned int), hash);
+        for(const auto& vertex : mesh.vertices){
+            hash = our::bvh_cache::hashBytes(&vertex.position, sizeof(vertex.position), hash);
+        }
+        return hash;
+    }
+
+    std::string getPath(std::uint64_t hash) {
+        char name[32];
+        std::snprintf(name, sizeof(name), "%016llx.hulls", static_cast<unsigned long long>(hash));
+        return (std::filesystem::path(cacheDirectory) / name).string();
+    }
+
+    // The file holds the number of parts then the number of points of each part followed by its points
+    // The counts are checked against the settings and the file size, so a corrupt file is decomposed again instead of trusted
+    bool load(std::uint64_t hash, const Settings& settings, Parts& parts) {
+        std::ifstream file(getPath(hash), std::ios::binary | std::ios::ate);
+        if(!file) return false;
+        std::streamoff remaining = file.tellg();
+        file.seekg(0);
+        char magic[4];
+        std::uint32_t partCount = 0;
+        if(!file.read(magic, 4) || !std::equal(magic, magic + 4, "HUL1")) return false;
+        if(!file.read(reinterpret_cast<char*>(&partCount), sizeof(partCount))) return false;
+        remaining -= 4 + sizeof(partCount);
+        if(partCount > static_cast<std::uint32_t>(settings.maxParts)) return false;
+        parts.assign(partCount, {});
+        for(auto& part : parts){
+            std::uint32_t pointCount = 0;
+            if(!file.read(reinterpret_cast<char*>(&pointCount), sizeof(pointCount))) return false;
+            remaining -= sizeof(pointCount);
+            if(pointCount < 4 || pointCount > static_cast<std::uint32_t>(settings.maxPointsPerPart)) return false;
+            std::streamoff bytes = static_cast<std::streamoff>(pointCount * sizeof(glm::vec3));
+            if(bytes > remaining) return false;
+            part.resize(pointCount);
+            if(!file.read(reinterpret_cast<char*>(part.data()), bytes)) return false;
+            remaining -= bytes;
+        }
+        return remaining == 0;
+    }
+
+    void save(std::uint64_t hash, const Parts& parts) {
+        std::string path = getPath(hash);
+        std::error_code ec;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+        if(ec) return;
+        std::ofstream file(path, std::ios::binary);
+        std::uint32_t partCount = static_cast<std::uint32_t>(parts.size());
+        file.write("HUL1", 4);
+        file.write(reinterpret_cast<const char*>(&partCount), sizeof(partCount));
+        for(const auto& part : parts){
+            std::uint32_t pointCount = static_cast<std::uint32_t>(part.size());
+            file.write(reinterpret_cast<const char*>(&pointCount), sizeof(pointCount));
+            file.write(reinterpret_cast<const char*>(part.data()), pointCount * sizeof(glm::vec3));
+        }
+        if(!file){
+            std::cerr << "Failed to write the convex decomposition cache: " << path << std::endl;
+            file.close();
+            std::filesystem::remove(path, ec);
+        }
+    }
+}
+
+Parts our::convex_decomposition::decompose(const Mesh& mesh, const Settings& settings) {
+    // Weld the vertices that share a position (they are duplicated for each normal and texture coordinate)
+    Triangles triangles;
+    std::vector<std::uint32_t> remap(mesh.vertices.size());
+    std::unordered_map<glm::vec3, std::uint32_t> welded;
+    for(size_t vertex = 0; vertex < mesh.vertices.size(); ++vertex){
+        auto [it, inserted] = welded.emplace(mesh.vertices[vertex].position, static_cast<std::uint32_t>(triangles.positions.size()));
+        if(inserted) triangles.positions.push_back(mesh.vertices[vertex].position);
+        remap[vertex] = it->second;
+    }
+    for(size_t index = 0; index + 2 < mesh.elements.size(); index += 3){
+        if(mesh.elements[index] >= mesh.vertices.size() || mesh.elements[index + 1] >= mesh.vertices.size() ||
+            mesh.elements[index + 2] >= mesh.vertices.size()) continue;
+        for(size_t corner = 0; corner < 3; ++corner) triangles.indices.push_back(remap[mesh.elements[index + corner]]);
+    }
+    if(triangles.indices.empty()) return {};
+
+    std::vector<std::uint32_t> stamps(triangles.positions.size(), 0);
+    std::uint32_t stamp = 0;
+
+    std::vector<Part> parts(1);
+    parts[0].triangles.resize(triangles.indices.size() / 3);
+    for(std::uint32_t triangle = 0; triangle < parts[0].triangles.size(); ++triangle) parts[0].triangles[triangle] = triangle;
+    evaluate(parts[0], triangles, settings, stamps, ++stamp);
+
+    float threshold = settings.concavity * glm::length(mesh.boundsMax - mesh.boundsMin);
+    while(parts.size() < static_cast<size_t>(settings.maxParts)){
+        // Pick the most concave part that can still be split
+        size_t worst = parts.size();
+        for(size_t index = 0; index < parts.size(); ++index){
+            const Part& part = parts[index];
+            if(part.concavity <= threshold || part.depth >= settings.maxDepth || part.triangles.size() < 2) continue;
+            if(worst == parts.size() || part.concavity > parts[worst].concavity) worst = index;
+        }
+        if(worst == parts.size()) break;
+
+        Part first, second;
+        if(!split(parts[worst], triangles, first, second)){
+            parts[worst].depth = settings.maxDepth; // It can't be split so don't pick it again
+            continue;
+        }
+        evaluate(first, triangles, settings, stamps, ++stamp);
+        evaluate(second, triangles, settings, stamps, ++stamp);
+        parts[worst] = std::move(first);
+        parts.push_back(std::move(second));
+    }
+
+    // Splitting at the median can cut a convex piece in two, so the touching parts are merged back while the union stays nearly convex
+    auto bounds = [](const Part& part){
+        std::pair<glm::vec3, glm::vec3> box(glm::vec3(std::numeric_limits<float>::max()), glm::vec3(-std::numeric_limits<float>::max()));
+        for(const auto& point : part.hull){
+            box.first = glm::min(box.first, point);
+            box.second = glm::max(box.second, point);
+        }
+        return box;
+    };
+    float tolerance = 1e-4f * glm::length(mesh.boundsMax - mesh.boundsMin);
+    for(bool merged = true; merged;){
+        merged = false;
+        for(size_t first = 0; first < parts.size() && !merged; ++first){
+            for(size_t second = first + 1; second < parts.size() && !merged; ++second){
+                auto [firstMin, firstMax] = bounds(parts[first]);
+                auto [secondMin, secondMax] = bounds(parts[second]);
+                if(glm::any(glm::greaterThan(firstMin, secondMax + tolerance)) || glm::any(glm::greaterThan(secondMin, firstMax + tolerance))) continue;
+                Part combined;
+                combined.triangles = parts[first].triangles;
+                combined.triangles.insert(combined.triangles.end(), parts[second].triangles.begin(), parts[second].triangles.end());
+                combined.depth = std::min(parts[first].depth, parts[second].depth);
+                evaluate(combined, triangles, settings, stamps, ++stamp);
+                if(combined.concavity > threshold) continue;
+                parts[first] = std::move(combined);
+                parts.erase(parts.begin() + second);
+                merged = true;
+            }
+        }
+    }
+
+    Parts result;
+    for(auto& part : parts){
+        if(part.hull.size() >= 4) result.push_back(std::move(part.hull));
+    }
+    return result;
+}
+
+Parts our::convex_decomposition::get(const Mesh& mesh, const Settings& settings) {
+    std::uint64_t hash = hashMesh(mesh, settings);
+    {
+        std::lock_guard<std::mutex> lock(memoryCacheMutex);
+        auto it = memoryCache.find(hash);
+        if(it != memoryCache.end()) return it->second;
+    }
+    Parts parts;
+    if(!load(hash, settings, parts)){
+        parts = decompose(mesh, settings);
+        save(hash, parts);
+        std::cout << "Convex decomposition: split " << mesh.elements.size() / 3 << " triangles into " << parts.size() << " parts" << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(memoryCacheMutex);
+    memoryCache[hash] = parts;
+    return parts;
+}
+
+void our::convex_decomposition::clearMemoryCache() {
+    std::lock_guard<std::mutex> lock(memoryCacheMutex);
+    memoryCache.clear();
+}
+
+void our::convex_decomposition::setDirectory(const std::string& directory) {
+    cacheDirectory = directory;
+}
+
+const std::string& our::convex_decomposition::getDirectory() {
+    return cacheDirectory;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../mesh/mesh.hpp"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace our::convex_decomposition {
+    // The convex parts of a mesh, each given by the points of its convex hull in the mesh local space
+    using Parts = std::vector<std::vector<glm::vec3>>;
+
+    struct Settings {
+        int maxParts = 16;          // The maximum number of convex parts
+        int maxDepth = 8;           // The maximum number of times a part can be split
+        int maxPointsPerPart = 24;  // The maximum number of hull points in each part
+        float concavity = 0.02f;    // A part is split while its concavity is above this fraction of the mesh diagonal
+    };
+
+    // Splits the triangles of the mesh into parts that are nearly convex.
+    // The part with the deepest concavity is split in two along the longest side of its bounding box until all the parts are
+    // nearly convex or the number of parts reaches the limit. The concavity of a part is measured as the distance of its hull points
+    // in front of its triangles (it is zero for a convex part whose triangles all lie on its hull).
+    // This is slow for big meshes, so it should be done through "get" which caches the results.
+    Parts decompose(const Mesh& mesh, const Settings& settings = {});
+
+    // Returns the decomposition of the mesh from the memory or disk cache or decomposes the mesh and caches the result.
+    // It can be called from multiple threads at once to decompose several meshes in parallel.
+    Parts get(const Mesh& mesh, const Settings& settings = {});
+
+    // Forgets the decompositions kept in memory (the disk cache is kept)
+    void clearMemoryCache();
+
+    // The directory in which the decompositions are saved (default: "assets/cache/hulls")
+    void setDirectory(const std::string& directory);
+    const std::string& getDirectory();
+}
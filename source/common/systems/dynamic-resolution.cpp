@@ -0,0 +1,100 @@
+#include "dynamic-resolution.hpp"
+
+#include <glm/common.hpp>
+
+namespace our {
+
+    void DynamicResolution::initialize(const nlohmann::json& config){
+        enabled = false;
+        if(!config.is_object()) return;
+        enabled = config.value("enabled", true);
+        targetFrameTime = config.value("targetFrameTime", targetFrameTime);
+        minScale = glm::clamp(config.value("minScale", minScale), 0.1f, 1.0f);
+        maxScale = glm::clamp(config.value("maxScale", maxScale), minScale, 1.0f);
+        scaleStep = config.value("step", scaleStep);
+        hysteresis = config.value("hysteresis", hysteresis);
+        cooldownFrames = config.value("cooldownFrames", cooldownFrames);
+        if(!enabled) return;
+
+        // We start at the highest quality and let the controller lower it if needed
+        scale = maxScale;
+        gpuFrameTime = 0.0f;
+        hasSample = false;
+        framesSinceChange = 0;
+        currentQuery = 0;
+        glGenQueries(QUERY_COUNT, queries);
+        for(bool& issued : queryIssued) issued = false;
+    }
+
+    void DynamicResolution::destroy(){
+        if(!enabled) return;
+        glDeleteQueries(QUERY_COUNT, queries);
+        for(bool& issued : queryIssued) issued = false;
+        enabled = false;
+    }
+
+    void DynamicResolution::beginFrame(){
+        if(!enabled) return;
+        // If the query in this slot is still in flight (its result never became available), we drop its result
+        glBeginQuery(GL_TIME_ELAPSED, queries[currentQuery]);
+        queryIssued[currentQuery] = true;
+    }
+
+    bool DynamicResolution::endFrame(){
+        if(!enabled) return false;
+        glEndQuery(GL_TIME_ELAPSED);
+        currentQuery = (currentQuery + 1) % QUERY_COUNT;
+
+        // The query in the next slot is the oldest one in flight, so it is the one most likely to be ready
+        bool newSample = false;
+        for(int offset = 0; offset < QUERY_COUNT - 1; ++offset){
+            int index = (currentQuery + offset) % QUERY_COUNT;
+            if(!queryIssued[index]) continue;
+            GLint available = 0;
+            glGetQueryObjectiv(queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(!available) break; // Queries complete in order, so the newer ones are not ready either
+            GLuint64 elapsed = 0;
+            glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &elapsed);
+            queryIssued[index] = false;
+
+            float milliseconds = float(elapsed) * 1e-6f;
+            gpuFrameTime = hasSample ? glm::mix(gpuFrameTime, milliseconds, smoothing) : milliseconds;
+            hasSample = true;
+            newSample = true;
+        }
+
+        ++framesSinceChange;
+        if(!newSample) return false;
+        return adjustScale();
+    }
+
+    bool DynamicResolution::adjustScale(){
+        if(framesSinceChange < cooldownFrames) return false;
+
+        float upper = targetFrameTime * (1.0f + hysteresis);
+        float lower = targetFrameTime * (1.0f - hysteresis);
+        float newScale = scale;
+        if(gpuFrameTime > upper){
+            newScale = glm::max(minScale, scale - scaleStep);
+        } else if(gpuFrameTime < lower){
+            float candidate = glm::min(maxScale, scale + scaleStep);
+            // The GPU cost roughly follows the pixel count, so we only grow if the larger target is expected to fit the target time.
+            // Otherwise, we would grow, overshoot the band, shrink again and so on.
+            float predicted = gpuFrameTime * (candidate * candidate) / (scale * scale);
+            if(predicted <= targetFrameTime) newScale = candidate;
+        }
+        if(newScale == scale) return false;
+
+        // Rescale the smoothed time to the new pixel count so that old samples don't trigger another change right away
+        gpuFrameTime *= (newScale * newScale) / (scale * scale);
+        scale = newScale;
+        framesSinceChange = 0;
+        return true;
+    }
+
+    glm::ivec2 DynamicResolution::getRenderSize(glm::ivec2 windowSize) const {
+        glm::ivec2 size = glm::ivec2(glm::vec2(windowSize) * scale + 0.5f);
+        return glm::max(size, glm::ivec2(1));
+    }
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glad/gl.h>
+#include <glm/vec2.hpp>
+#include <json/json.hpp>
+
+namespace our {
+
+    // Dynamic resolution scales the internal render target of the forward renderer based on the time the GPU spends on a frame.
+    // The GPU time is measured using timer queries. Since reading a query result right after the frame would stall the CPU
+    // till the GPU finishes, we keep a ring of queries in flight and only read the ones whose results became available.
+    // To prevent the scale from oscillating, it is only changed when the frame time leaves a band around the target,
+    // it only grows if the predicted frame time at the larger scale still fits the target,
+    // and it is kept constant for a few frames after each change to let the measurements settle.
+    class DynamicResolution {
+        // The number of timer queries that can be in flight at the same time
+        static constexpr int QUERY_COUNT = 4;
+        GLuint queries[QUERY_COUNT] = {};
+        bool queryIssued[QUERY_COUNT] = {};
+        int currentQuery = 0;
+
+        bool enabled = false;
+        float targetFrameTime = 16.6f;  // The GPU frame time (in milliseconds) that we try to stay under
+        float minScale = 0.5f;          // The lowest allowed scale of the render target relative to the window
+        float maxScale = 1.0f;          // The highest allowed scale of the render target relative to the window
+        float scaleStep = 0.05f;        // How much the scale changes in a single adjustment
+        float hysteresis = 0.1f;        // The half width of the band (relative to the target) in which the scale is kept as is
+        int cooldownFrames = 30;        // The number of frames to wait after a scale change before changing it again
+        float smoothing = 0.1f;         // The weight of the newest sample in the exponential moving average of the GPU time
+
+        float scale = 1.0f;
+        float gpuFrameTime = 0.0f;      // The smoothed GPU frame time in milliseconds
+        bool hasSample = false;
+        int framesSinceChange = 0;
+
+        // Picks a new scale based on the current smoothed GPU frame time. Returns true if the scale changed.
+        bool adjustScale();
+    public:
+        // Reads the options from the "dynamicResolution" object of the renderer configuration and creates the timer queries
+        // The object can contain: "enabled", "targetFrameTime", "minScale", "maxScale", "step", "hysteresis", "cooldownFrames"
+        void initialize(const nlohmann::json& config);
+        // Deletes the timer queries
+        void destroy();
+
+        bool isEnabled() const { return enabled; }
+
+        // Starts measuring the GPU time of the current frame
+        void beginFrame();
+        // Stops measuring the GPU time of the current frame, collects any available results and updates the scale
+        // Returns true if the scale changed (which means that the render targets should be resized)
+        bool endFrame();
+
+        // Returns the current scale of the render target relative to the window
+        float getScale() const { return scale; }
+        // Returns the smoothed GPU frame time in milliseconds
+        float getGpuFrameTime() const { return gpuFrameTime; }
+        // Returns the size of the render target for the given window size at the current scale
+        glm::ivec2 getRenderSize(glm::ivec2 windowSize) const;
+    };
+
+}
@@ -1,7 +1,7 @@
 ﻿#include "forward-renderer.hpp"
-#include "../mesh/mesh-utils.hpp"
 #include "../texture/texture-utils.hpp"
 #include <iostream>
+#include <limits>
 
 namespace our {
 
@@ -9,76 +9,118 @@ namespace our {
         // First, we store the window size for later use
         this->windowSize = windowSize;
 
+        // Create an empty vertex array to use for drawing fullscreen triangles (the vertices are generated in the vertex shader)
+        // It is used to draw the sky and the postprocessing passes
+        glGenVertexArrays(1, &fullscreenVertexArray);
+
         // Then we check if there is a sky texture in the configuration
+        // The sky can be an equirectangular image: "sky": "path/to/image"
+        // or a cube map: "sky": { "cubemap": [ "+X", "-X", "+Y", "-Y", "+Z", "-Z" ] } where each element is a path to an image
         if(config.contains("sky")){
-            // First, we create a sphere which will be used to draw the sky
-            this->skySphere = mesh_utils::sphere(glm::ivec2(16, 16));
-            
-            // We can draw the sky using the same shader used to draw textured objects
+            const auto& skyConfig = config["sky"];
+            std::string skyFragmentShader = "assets/shaders/sky.frag";
+
+            // Setup a sampler for the sky
+            skySampler = new Sampler();
+            skySampler->set(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            skySampler->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            // Load the sky texture (note that we don't need mipmaps since we want to avoid any unnecessary blurring while rendering the sky)
+            if(skyConfig.is_object() && skyConfig.contains("cubemap")){
+                std::array<std::string, 6> faces;
+                const auto& facesConfig = skyConfig["cubemap"];
+                for(size_t face = 0; face < faces.size() && face < facesConfig.size(); ++face){
+                    faces[face] = facesConfig[face].get<std::string>();
+                }
+                skyCubemap = texture_utils::loadCubemap(faces);
+                skySampler->set(GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                skySampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                skySampler->set(GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+                skyFragmentShader = "assets/shaders/sky-cubemap.frag";
+            } else {
+                skyTexture = texture_utils::loadImage(skyConfig.get<std::string>(), false);
+                skySampler->set(GL_TEXTURE_WRAP_S, GL_REPEAT);
+                skySampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            }
+
+            // The sky is drawn as a fullscreen triangle on the far plane whose pixels reconstruct their view rays,
+            // so it needs no geometry and only shades the pixels that are not covered by any object
             ShaderProgram* skyShader = new ShaderProgram();
-            skyShader->attach("assets/shaders/textured.vert", GL_VERTEX_SHADER);
-            skyShader->attach("assets/shaders/textured.frag", GL_FRAGMENT_SHADER);
+            skyShader->attach("assets/shaders/sky.vert", GL_VERTEX_SHADER);
+            skyShader->attach(skyFragmentShader, GL_FRAGMENT_SHADER);
             skyShader->link();
-            
+
             //TODO: (Req 10) Pick the correct pipeline state to draw the sky
-            // Hints: the sky will be draw after the opaque objects so we would need depth testing but which depth funtion should we pick?
-            // We will draw the sphere from the inside, so what options should we pick for the face culling.
+            // The sky will be drawn after the opaque objects at the far plane, so we test against the depth with GL_LEQUAL
+            // (the cleared depth is 1 which is exactly the depth of the sky) and we don't need to write the depth.
             PipelineState skyPipelineState{};
             skyPipelineState.depthTesting.enabled = true;
             skyPipelineState.depthTesting.function = GL_LEQUAL;
-			skyPipelineState.depthMask = false;
-			skyPipelineState.faceCulling.enabled = true;
-			skyPipelineState.faceCulling.culledFace = GL_FRONT;
-			skyPipelineState.blending.enabled = false;
-            
-            // Load the sky texture (note that we don't need mipmaps since we want to avoid any unnecessary blurring while rendering the sky)
-            std::string skyTextureFile = config.value<std::string>("sky", "");
-            Texture2D* skyTexture = texture_utils::loadImage(skyTextureFile, false);
+            skyPipelineState.depthMask = false;
+            skyPipelineState.faceCulling.enabled = false;
+            skyPipelineState.blending.enabled = false;
 
-            // Setup a sampler for the sky 
-            Sampler* skySampler = new Sampler();
-            skySampler->set(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            skySampler->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-            skySampler->set(GL_TEXTURE_WRAP_S, GL_REPEAT);
-            skySampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-            // Combine all the aforementioned objects (except the mesh) into a material 
-            this->skyMaterial = new TexturedMaterial();
+            this->skyMaterial = new Material();
             this->skyMaterial->shader = skyShader;
-            this->skyMaterial->texture = skyTexture;
-            this->skyMaterial->sampler = skySampler;
             this->skyMaterial->pipelineState = skyPipelineState;
-            this->skyMaterial->tint = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-            this->skyMaterial->alphaThreshold = 1.0f;
             this->skyMaterial->transparent = false;
         }
 
-        // Then we check if there is a postprocessing shader in the configuration
-        if(config.contains("postprocess")){
-            // Create a framebuffer
-            glGenFramebuffers(1, &postprocessFrameBuffer);
-            glBindFramebuffer(GL_FRAMEBUFFER, postprocessFrameBuffer);
-
-            // Create a color and a depth texture and attach them to the framebuffer
-            // Color: RGBA8, Depth: 24-bit depth
-            colorTarget = texture_utils::empty(GL_RGBA8, windowSize);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTarget->getOpenGLName(), 0);
+        // Then we check if dynamic resolution is requested in the configuration
+        if(config.contains("dynamicResolution")){
+            dynamicResolution.initialize(config["dynamicResolution"]);
+        }
+        renderSize = dynamicResolution.isEnabled() ? dynamicResolution.getRenderSize(windowSize) : windowSize;
 
-            depthTarget = texture_utils::empty(GL_DEPTH_COMPONENT24, windowSize);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTarget->getOpenGLName(), 0);
+        // Then we read the level of detail options
+        if(config.contains("lod")){
+            lodHysteresis = config["lod"].value("hysteresis", lodHysteresis);
+            lodBias = config["lod"].value("bias", lodBias);
+        }
 
-            // Check framebuffer completeness
-            if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
-                std::cerr << "ERROR: Postprocess framebuffer is not complete" << std::endl;
-            }
+        // Then we check if occlusion culling is requested in the configuration
+        if(config.contains("occlusionCulling")){
+            occlusionCulling.initialize(config["occlusionCulling"]);
+        }
 
-            // Unbind the framebuffer just to be safe
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        // Then we read the anti-aliasing options
+        // "msaa" is the number of samples of the multisampled scene framebuffer (0 or 1 means no MSAA)
+        // "fxaa" enables a cheap postprocessing anti-aliasing pass which is a good fallback for low-end hardware
+        msaaSamples = config.value("msaa", 0);
+        if(msaaSamples > 1){
+            GLint maxSamples = 0;
+            glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+            msaaSamples = glm::min(msaaSamples, (int)maxSamples);
+        }
+        if(msaaSamples < 2) msaaSamples = 0;
+        bool fxaa = config.value("fxaa", false);
+
+        // Then we read how transparent objects should be drawn
+        // "sorted" (the default) sorts them from far to near every frame and blends them in order
+        // "oit" uses weighted blended order-independent transparency which needs no sorting and handles intersecting objects
+        orderIndependentTransparency = config.value<std::string>("transparency", "sorted") == "oit";
+
+        // Then we check if we need to render the scene into an offscreen framebuffer
+        // This is needed for postprocessing, for dynamic resolution (where the scene is rendered at a lower resolution then upscaled)
+        // for anti-aliasing (where the scene is resolved or filtered before being presented)
+        // for OIT (where the transparent objects are composited over the scene texture)
+        // and for occlusion culling (where the depth target is reduced into the Hi-Z pyramid)
+        if(config.contains("postprocess") || dynamicResolution.isEnabled() || msaaSamples > 0 || fxaa || orderIndependentTransparency
+            || occlusionCulling.isEnabled()){
+            // Create a framebuffer
+            glGenFramebuffers(1, &postprocessFrameBuffer);
+            // The scene is drawn into a multisampled framebuffer then resolved into the postprocess framebuffer
+            if(msaaSamples > 0) glGenFramebuffers(1, &multisampleFrameBuffer);
+            // If FXAA runs before a postprocessing effect, it needs its own target
+            if(fxaa && config.contains("postprocess")) glGenFramebuffers(1, &fxaaFrameBuffer);
+            // The transparent objects accumulate into the OIT framebuffer
+            if(orderIndependentTransparency) glGenFramebuffers(1, &oitFrameBuffer);
 
-            // Create a vertex array to use for drawing the texture
-            glGenVertexArrays(1, &postProcessVertexArray);
+            // Create a color and a depth texture and attach them to the framebuffer
+            createRenderTargets(renderSize);
 
             // Create a sampler to use for sampling the scene texture in the post processing shader
+            // Linear filtering is what upscales the scene when it is rendered at a lower resolution
             Sampler* postprocessSampler = new Sampler();
             postprocessSampler->set(GL_TEXTURE_MIN_FILTER, GL_LINEAR);
             postprocessSampler->set(GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -86,41 +128,299 @@ namespace our {
             postprocessSampler->set(GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
             // Create the post processing shader
+            // If no postprocessing effect is requested, we just blit the scene texture to the screen
+            // (or apply FXAA while doing so, which saves a fullscreen pass)
+            std::string fxaaShaderFile = "assets/shaders/postprocess/fxaa.frag";
             ShaderProgram* postprocessShader = new ShaderProgram();
             postprocessShader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
-            postprocessShader->attach(config.value<std::string>("postprocess", ""), GL_FRAGMENT_SHADER);
+            postprocessShader->attach(config.value<std::string>("postprocess", fxaa ? fxaaShaderFile : "assets/shaders/blit.frag"), GL_FRAGMENT_SHADER);
             postprocessShader->link();
 
+            // If FXAA has to run before a postprocessing effect, create a material for a separate FXAA pass
+            if(fxaaFrameBuffer){
+                ShaderProgram* fxaaShader = new ShaderProgram();
+                fxaaShader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
+                fxaaShader->attach(fxaaShaderFile, GL_FRAGMENT_SHADER);
+                fxaaShader->link();
+
+                fxaaMaterial = new TexturedMaterial();
+                fxaaMaterial->shader = fxaaShader;
+                fxaaMaterial->texture = colorTarget;
+                fxaaMaterial->sampler = postprocessSampler;
+                fxaaMaterial->pipelineState.depthMask = false;
+            }
+
             // Create a post processing material
             postprocessMaterial = new TexturedMaterial();
             postprocessMaterial->shader = postprocessShader;
-            postprocessMaterial->texture = colorTarget;
+            postprocessMaterial->texture = fxaaMaterial ? fxaaTarget : colorTarget;
             postprocessMaterial->sampler = postprocessSampler;
             // The default options are fine but we don't need to interact with the depth buffer
             // so it is more performant to disable the depth mask
             postprocessMaterial->pipelineState.depthMask = false;
+
+            // Create the material that composites the OIT targets over the scene
+            if(oitFrameBuffer){
+                ShaderProgram* oitCompositeShader = new ShaderProgram();
+                oitCompositeShader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
+                oitCompositeShader->attach("assets/shaders/oit-composite.frag", GL_FRAGMENT_SHADER);
+                oitCompositeShader->link();
+
+                // The shader outputs the average transparent color with the revealage in the alpha channel
+                // so the scene is kept in proportion to the revealage and the transparent color fills the rest
+                oitCompositeMaterial = new Material();
+                oitCompositeMaterial->shader = oitCompositeShader;
+                oitCompositeMaterial->pipelineState.blending.enabled = true;
+                oitCompositeMaterial->pipelineState.blending.sourceFactor = GL_ONE_MINUS_SRC_ALPHA;
+                oitCompositeMaterial->pipelineState.blending.destinationFactor = GL_SRC_ALPHA;
+                oitCompositeMaterial->pipelineState.depthMask = false;
+                oitCompositeMaterial->transparent = true;
+            }
+        }
+    }
+
+    void ForwardRenderer::createRenderTargets(glm::ivec2 size){
+        glBindFramebuffer(GL_FRAMEBUFFER, postprocessFrameBuffer);
+
+        // Color: RGBA8, Depth: 24-bit depth
+        colorTarget = texture_utils::empty(GL_RGBA8, size);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, colorTarget->getOpenGLName(), 0);
+
+        depthTarget = texture_utils::empty(GL_DEPTH_COMPONENT24, size);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTarget->getOpenGLName(), 0);
+
+        // Check framebuffer completeness
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+            std::cerr << "ERROR: Postprocess framebuffer is not complete" << std::endl;
+        }
+
+        // If MSAA is enabled, the scene is drawn into multisampled renderbuffers (which are cheaper than multisampled textures
+        // since we never sample them), then resolved into the color & depth targets above using glBlitFramebuffer
+        if(multisampleFrameBuffer){
+            glBindFramebuffer(GL_FRAMEBUFFER, multisampleFrameBuffer);
+
+            glGenRenderbuffers(1, &multisampleColorBuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, multisampleColorBuffer);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaaSamples, GL_RGBA8, size.x, size.y);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, multisampleColorBuffer);
+
+            // The depth format must match the depth target so that the depth can be resolved too
+            glGenRenderbuffers(1, &multisampleDepthBuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, multisampleDepthBuffer);
+            glRenderbufferStorageMultisample(GL_RENDERBUFFER, msaaSamples, GL_DEPTH_COMPONENT24, size.x, size.y);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, multisampleDepthBuffer);
+            glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+            if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+                std::cerr << "ERROR: Multisample framebuffer is not complete" << std::endl;
+            }
+        }
+
+        // If FXAA runs before a postprocessing effect, it writes into its own color target
+        if(fxaaFrameBuffer){
+            glBindFramebuffer(GL_FRAMEBUFFER, fxaaFrameBuffer);
+
+            fxaaTarget = texture_utils::empty(GL_RGBA8, size);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, fxaaTarget->getOpenGLName(), 0);
+
+            if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+                std::cerr << "ERROR: FXAA framebuffer is not complete" << std::endl;
+            }
+        }
+
+        // The OIT targets are:
+        // - RGBA16F: the sum of the weighted premultiplied colors (rgb) and the revealage (alpha)
+        // - R16F: the sum of the weighted alphas
+        // Both need floating point formats since the weighted sums can be larger than 1
+        if(oitFrameBuffer){
+            glBindFramebuffer(GL_FRAMEBUFFER, oitFrameBuffer);
+
+            oitAccumTarget = texture_utils::empty(GL_RGBA16F, size);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, oitAccumTarget->getOpenGLName(), 0);
+            oitWeightTarget = texture_utils::empty(GL_R16F, size);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, oitWeightTarget->getOpenGLName(), 0);
+            // The scene depth is shared so that the transparent objects behind opaque ones are rejected by the depth test
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depthTarget->getOpenGLName(), 0);
+
+            GLenum drawBuffers[] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1 };
+            glDrawBuffers(2, drawBuffers);
+
+            if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+                std::cerr << "ERROR: OIT framebuffer is not complete" << std::endl;
+            }
+        }
+
+        // Unbind the framebuffer just to be safe
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void ForwardRenderer::destroyRenderTargets(){
+        delete colorTarget;
+        delete depthTarget;
+        delete fxaaTarget;
+        delete oitAccumTarget;
+        delete oitWeightTarget;
+        colorTarget = depthTarget = fxaaTarget = nullptr;
+        oitAccumTarget = oitWeightTarget = nullptr;
+        if(multisampleFrameBuffer){
+            glDeleteRenderbuffers(1, &multisampleColorBuffer);
+            glDeleteRenderbuffers(1, &multisampleDepthBuffer);
+            multisampleColorBuffer = multisampleDepthBuffer = 0;
+        }
+    }
+
+    void ForwardRenderer::resizeRenderTargets(glm::ivec2 size){
+        renderSize = size;
+        destroyRenderTargets();
+        createRenderTargets(size);
+        if(fxaaMaterial){
+            fxaaMaterial->texture = colorTarget;
+            postprocessMaterial->texture = fxaaTarget;
+        } else {
+            postprocessMaterial->texture = colorTarget;
         }
     }
 
     void ForwardRenderer::destroy(){
         // Delete all objects related to the sky
         if(skyMaterial){
-            delete skySphere;
             delete skyMaterial->shader;
-            delete skyMaterial->texture;
-            delete skyMaterial->sampler;
             delete skyMaterial;
+            delete skyTexture;
+            delete skyCubemap;
+            delete skySampler;
+            skyMaterial = nullptr;
+            skyTexture = nullptr;
+            skyCubemap = nullptr;
+            skySampler = nullptr;
         }
+        glDeleteVertexArrays(1, &fullscreenVertexArray);
         // Delete all objects related to post processing
         if(postprocessMaterial){
             glDeleteFramebuffers(1, &postprocessFrameBuffer);
-            glDeleteVertexArrays(1, &postProcessVertexArray);
-            delete colorTarget;
-            delete depthTarget;
+            destroyRenderTargets();
+            if(multisampleFrameBuffer) glDeleteFramebuffers(1, &multisampleFrameBuffer);
+            if(fxaaFrameBuffer) glDeleteFramebuffers(1, &fxaaFrameBuffer);
+            if(oitFrameBuffer) glDeleteFramebuffers(1, &oitFrameBuffer);
+            multisampleFrameBuffer = fxaaFrameBuffer = oitFrameBuffer = 0;
+            if(oitCompositeMaterial){
+                delete oitCompositeMaterial->shader;
+                delete oitCompositeMaterial;
+                oitCompositeMaterial = nullptr;
+            }
+            if(fxaaMaterial){
+                // The sampler is shared with the postprocess material so it is deleted below
+                delete fxaaMaterial->shader;
+                delete fxaaMaterial;
+                fxaaMaterial = nullptr;
+            }
             delete postprocessMaterial->sampler;
             delete postprocessMaterial->shader;
             delete postprocessMaterial;
+            postprocessMaterial = nullptr;
         }
+        dynamicResolution.destroy();
+        occlusionCulling.destroy();
+    }
+
+    void ForwardRenderer::drawCommand(const RenderCommand& command, const glm::mat4& VP, bool oitPass) {
+        glm::mat4 transform = VP * command.localToWorld;
+
+        // Setup the material and send the transform (and whether the shader should write to the OIT targets)
+        auto setupMaterial = [&](const Material* material) {
+            material->setup();
+            material->shader->set("transform", transform);
+            // Shaders without OIT support have no "oit" uniform
+            if (material->shader->supportsOIT()) material->shader->set("oit", (GLint)oitPass);
+            if (oitPass) {
+                // The color sums are additive and the revealage is multiplied by (1 - alpha)
+                // Since GL 3.3 has no per-target blending, the weight target uses the additive rgb factors too
+                glEnable(GL_BLEND);
+                glBlendEquation(GL_FUNC_ADD);
+                glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ZERO, GL_ONE_MINUS_SRC_ALPHA);
+                glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+                glDepthMask(GL_FALSE);
+            }
+        };
+
+        // MULTI-MATERIAL DRAWING
+        if (!command.mesh->submeshes.empty()) {
+            GLuint vao = command.mesh->getVAO();
+            glBindVertexArray(vao);
+
+            for (auto& sub : command.mesh->submeshes) {
+
+                const Material* matToUse = getSubmeshMaterial(command, sub);
+                if (!matToUse) continue;
+
+                setupMaterial(matToUse);
+
+                glDrawElements(
+                    GL_TRIANGLES,
+                    sub.count,
+                    GL_UNSIGNED_INT,
+                    (void*)(sub.offset * sizeof(GLuint))
+                );
+            }
+
+            glBindVertexArray(0);
+        }
+        else {
+            // Single-material mesh
+            setupMaterial(command.material);
+            command.mesh->draw();
+        }
+    }
+
+    const Material* ForwardRenderer::getSubmeshMaterial(const RenderCommand& command, const Mesh::Submesh& submesh) {
+        // Try material matching the .mtl name
+        const Material* material = AssetLoader<Material>::get(submesh.materialName);
+        // If not found, fallback to the material set in JSON
+        return material ? material : command.material;
+    }
+
+    bool ForwardRenderer::supportsOIT(const RenderCommand& command) {
+        if (command.mesh->submeshes.empty()) return command.material->shader->supportsOIT();
+        for (const auto& sub : command.mesh->submeshes) {
+            const Material* material = getSubmeshMaterial(command, sub);
+            if (material && !material->shader->supportsOIT()) return false;
+        }
+        return true;
+    }
+
+    void ForwardRenderer::selectLevelOfDetail(RenderCommand& command, const CameraComponent* camera, const glm::vec3& cameraPosition) {
+        Mesh* mesh = command.meshRenderer->mesh;
+        int& level = command.meshRenderer->lod;
+        int levelCount = 1 + (int)mesh->lods.size();
+        if (levelCount == 1) {
+            level = 0;
+            return;
+        }
+
+        // Find the bounding sphere in the world space (the radius is scaled by the largest scale of the transform)
+        const glm::mat4& M = command.localToWorld;
+        float scale = glm::max(glm::length(glm::vec3(M[0])), glm::max(glm::length(glm::vec3(M[1])), glm::length(glm::vec3(M[2]))));
+        float radius = mesh->getBoundingRadius() * scale;
+        glm::vec3 center = glm::vec3(M * glm::vec4(mesh->getBoundingCenter(), 1.0f));
+
+        // The projected size is the diameter of the sphere relative to the screen height
+        float size;
+        if (camera->cameraType == CameraType::ORTHOGRAPHIC) {
+            size = 2.0f * radius / camera->orthoHeight;
+        } else {
+            float distance = glm::distance(center, cameraPosition);
+            // If the camera is inside the sphere, the object covers the screen
+            size = distance > radius ? radius / (distance * glm::tan(camera->fovY * 0.5f)) : std::numeric_limits<float>::max();
+        }
+        size *= lodBias;
+
+        // Starting from the level of the last frame, move to a coarser level only if the size is clearly below its threshold
+        // and move back to a finer level only if the size is clearly above the threshold of the current level.
+        // The band between the two prevents the level from flickering when the size stays near a threshold.
+        level = glm::clamp(level, 0, levelCount - 1);
+        while (level + 1 < levelCount && size < mesh->lods[level].screenSize * (1.0f - lodHysteresis)) ++level;
+        while (level > 0 && size > mesh->lods[level - 1].screenSize * (1.0f + lodHysteresis)) --level;
+        command.mesh = level == 0 ? mesh : mesh->lods[level - 1].mesh;
     }
 
     void ForwardRenderer::render(World* world) {
@@ -128,30 +428,68 @@ namespace our {
         CameraComponent* camera = nullptr;
         opaqueCommands.clear();
         transparentCommands.clear();
+        oitCommands.clear();
+
+        // Pick the first camera in the world
+        world->forEach<CameraComponent>([&](CameraComponent* component) {
+            if (!camera) camera = component;
+        });
+
+        // Loop through the mesh renderers (stored contiguously in the world) to collect their draw data
+        world->forEach<MeshRendererComponent>([&](MeshRendererComponent* meshRenderer) {
+            RenderCommand command;
+            command.localToWorld = meshRenderer->getOwner()->getLocalToWorldMatrix();
+            command.center = glm::vec3(command.localToWorld * glm::vec4(0, 0, 0, 1));
+            command.mesh = meshRenderer->mesh;
+            command.material = meshRenderer->material;
+            command.meshRenderer = meshRenderer;
+
+            // Separate transparent and opaque commands
+            // (in OIT mode, the transparent commands are split between the OIT pass and the sorted path once their level of detail is picked)
+            if (command.material->transparent)
+                transparentCommands.push_back(command);
+            else
+                opaqueCommands.push_back(command);
+        });
+
+        // Cannot render without a camera
+        if (camera == nullptr) return;
 
-        // Loop through entities to find camera and mesh renderers
-        for (auto entity : world->getEntities()) {
-            // If no camera yet, try to get one
-            if (!camera) camera = entity->getComponent<CameraComponent>();
-
-            // If this entity has a mesh renderer, collect its draw data
-            if (auto meshRenderer = entity->getComponent<MeshRendererComponent>()) {
-                RenderCommand command;
-                command.localToWorld = meshRenderer->getOwner()->getLocalToWorldMatrix();
-                command.center = glm::vec3(command.localToWorld * glm::vec4(0, 0, 0, 1));
-                command.mesh = meshRenderer->mesh;
-                command.material = meshRenderer->material;
-
-                // Separate transparent and opaque commands
-                if (command.material->transparent)
-                    transparentCommands.push_back(command);
-                else
-                    opaqueCommands.push_back(command);
+        // Skip the commands that are hidden behind the depth captured in the previous frame
+        stats = RenderStats();
+        if (occlusionCulling.isEnabled()) {
+            occlusionCulling.beginFrame();
+            auto isOccluded = [this](const RenderCommand& command) {
+                ++stats.occlusionTested;
+                bool occluded = occlusionCulling.isOccluded(command.localToWorld, command.mesh->boundsMin, command.mesh->boundsMax);
+                if (occluded) ++stats.occlusionCulled;
+                return occluded;
+            };
+            opaqueCommands.erase(std::remove_if(opaqueCommands.begin(), opaqueCommands.end(), isOccluded), opaqueCommands.end());
+            transparentCommands.erase(std::remove_if(transparentCommands.begin(), transparentCommands.end(), isOccluded), transparentCommands.end());
+        }
+        stats.opaqueCommands = (int)opaqueCommands.size();
+        stats.transparentCommands = (int)transparentCommands.size();
+
+        // Pick the level of detail of the visible commands and count the triangles drawn at each level
+        glm::vec3 cameraPosition = glm::vec3(camera->getOwner()->getLocalToWorldMatrix()[3]);
+        for (auto* commands : { &opaqueCommands, &transparentCommands }) {
+            for (auto& command : *commands) {
+                selectLevelOfDetail(command, camera, cameraPosition);
+                int level = glm::min(command.meshRenderer->lod, RenderStats::LOD_LEVELS - 1);
+                stats.lodCommands[level]++;
+                stats.lodTriangles[level] += command.mesh->getElementCount() / 3;
             }
         }
 
-        // Cannot render without a camera
-        if (camera == nullptr) return;
+        // In OIT mode, the transparent commands go to the OIT pass only if every material they are drawn with supports it
+        // (a submesh material whose shader doesn't write the OIT targets would corrupt them), the rest fall back to the sorted path
+        if (oitFrameBuffer) {
+            auto sortedBegin = std::partition(transparentCommands.begin(), transparentCommands.end(),
+                [](const RenderCommand& command) { return !supportsOIT(command); });
+            oitCommands.assign(sortedBegin, transparentCommands.end());
+            transparentCommands.erase(sortedBegin, transparentCommands.end());
+        }
 
         // === 2) Sort transparent objects from far → near ======================
         glm::mat4 cameraWorld = camera->getOwner()->getLocalToWorldMatrix();
@@ -160,6 +498,7 @@ namespace our {
         glm::vec3 cameraForward = glm::normalize(glm::vec3(cameraWorld * glm::vec4(0, 0, -1, 0)));
 
         // Sort transparent objects by distance along the camera forward direction
+        // (the objects drawn by the OIT pass are not in this list, so they are never sorted)
         std::sort(transparentCommands.begin(), transparentCommands.end(),
             [cameraForward](const RenderCommand& a, const RenderCommand& b) {
                 float da = glm::dot(cameraForward, a.center);
@@ -173,8 +512,12 @@ namespace our {
         glm::mat4 proj = camera->getProjectionMatrix(windowSize);
         glm::mat4 VP = proj * view;
 
+        // Start measuring the GPU time of this frame (if dynamic resolution is enabled)
+        dynamicResolution.beginFrame();
+
         // === 4) Setup viewport & clear buffers ================================
-        glViewport(0, 0, windowSize.x, windowSize.y);
+        // The scene is drawn at the render size which is smaller than the window if dynamic resolution lowered the scale
+        glViewport(0, 0, renderSize.x, renderSize.y);
         glClearColor(0, 0, 0, 1);
         glClearDepth(1.0);
         glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
@@ -182,8 +525,8 @@ namespace our {
 
         // If postprocessing enabled → render to framebuffer
         if (postprocessMaterial) {
-            // Bind framebuffer before rendering scene
-            glBindFramebuffer(GL_FRAMEBUFFER, postprocessFrameBuffer);
+            // Bind framebuffer before rendering scene (the multisampled one if MSAA is enabled)
+            glBindFramebuffer(GL_FRAMEBUFFER, multisampleFrameBuffer ? multisampleFrameBuffer : postprocessFrameBuffer);
         }
 
         // Clear color and depth
@@ -191,89 +534,29 @@ namespace our {
 
         // === 5) Draw opaque objects ==========================================
         for (const auto& cmd : opaqueCommands) {
-            cmd.material->setup();
-            cmd.material->shader->use();
-
-            // Compute MVP transform and send to shader
-            glm::mat4 transform = VP * cmd.localToWorld;
-            cmd.material->shader->set("transform", transform);
-
-            // Draw the mesh
-            //cmd.mesh->draw();
-            // MULTI-MATERIAL DRAWING
-            if (!cmd.mesh->submeshes.empty()) {
-                GLuint vao = cmd.mesh->getVAO();
-                glBindVertexArray(vao);
-
-                for (auto& sub : cmd.mesh->submeshes) {
-
-                    // Try material matching the .mtl name
-                    Material* matToUse = AssetLoader<Material>::get(sub.materialName);
-
-                    // If not found, fallback to the material set in JSON
-                    if (!matToUse) matToUse = cmd.material;
-                    if (!matToUse) continue;
-
-                    matToUse->setup();
-                    matToUse->shader->use();
-
-                    glm::mat4 transform = VP * cmd.localToWorld;
-                    matToUse->shader->set("transform", transform);
-
-                    glDrawElements(
-                        GL_TRIANGLES,
-                        sub.count,
-                        GL_UNSIGNED_INT,
-                        (void*)(sub.offset * sizeof(GLuint))
-                    );
-                }
-
-                glBindVertexArray(0);
-            }
-            else {
-                // Single-material mesh
-                cmd.material->setup();
-                cmd.material->shader->use();
-
-                glm::mat4 transform = VP * cmd.localToWorld;
-                cmd.material->shader->set("transform", transform);
-
-                cmd.mesh->draw();
-            }
-
+            drawCommand(cmd, VP, false);
         }
 
         // === 6) Draw sky (Req 10) ============================================
         if (skyMaterial) {
-            // Apply sky pipeline state (depth test ON, depth mask OFF, cull front)
+            // Apply sky pipeline state (depth test ON with GL_LEQUAL, depth mask OFF)
             skyMaterial->setup();
-            skyMaterial->shader->use();
-
-            // Get camera position
-            glm::vec3 cameraPos = glm::vec3(cameraWorld * glm::vec4(0, 0, 0, 1));
-
-            // Model matrix for sky: center it around camera
-            glm::mat4 model = glm::translate(glm::mat4(1.0f), cameraPos);
-
-            // Optionally scale sky sphere (large enough to cover entire view)
-            model = glm::scale(model, glm::vec3(100.0f));
-
-            // Transform = VP * model
-            glm::mat4 transform = VP * model;
-
-            // Force the sky to be at the far plane by setting NDC z = 1 for all vertices.
-            // This is achieved by making the 3rd row of the transform equal to the 4th row
-            // so that gl_Position.z == gl_Position.w after the vertex shader transform.
-            for(int c = 0; c < 4; ++c){
-                transform[c][2] = transform[c][3];
-            }
 
-            // Set transform uniform
-            skyMaterial->shader->set("transform", transform);
+            // The sky is infinitely far, so we remove the camera translation from the view matrix.
+            // The inverse of the resulting VP matrix takes each pixel from NDC back to its view direction.
+            glm::mat4 skyVP = proj * glm::mat4(glm::mat3(view));
+            skyMaterial->shader->set("inverse_view_projection", glm::inverse(skyVP));
 
-            // Draw sky sphere
-            skySphere->draw();
+            glActiveTexture(GL_TEXTURE0);
+            if (skyCubemap) skyCubemap->bind();
+            else if (skyTexture) skyTexture->bind();
+            skySampler->bind(0);
+            skyMaterial->shader->set("tex", 0);
 
+            // Draw a fullscreen triangle on the far plane
+            glBindVertexArray(fullscreenVertexArray);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
         }
 
         // === 7) Draw transparent objects =====================================
@@ -282,69 +565,95 @@ namespace our {
         glDepthMask(GL_FALSE); // don't overwrite depth
 
         for (const auto& cmd : transparentCommands) {
-            cmd.material->setup();
-            cmd.material->shader->use();
-
-            glm::mat4 transform = VP * cmd.localToWorld;
-            cmd.material->shader->set("transform", transform);
-            // MULTI-MATERIAL DRAWING
-            if (!cmd.mesh->submeshes.empty()) {
-                GLuint vao = cmd.mesh->getVAO();
-                glBindVertexArray(vao);
-
-                for (auto& sub : cmd.mesh->submeshes) {
-
-                    // Try material matching the .mtl name
-                    Material* matToUse = AssetLoader<Material>::get(sub.materialName);
-
-                    // If not found, fallback to the material set in JSON
-                    if (!matToUse) matToUse = cmd.material;
-                    if (!matToUse) continue;
-
-                    matToUse->setup();
-                    matToUse->shader->use();
+            drawCommand(cmd, VP, false);
+        }
 
-                    glm::mat4 transform = VP * cmd.localToWorld;
-                    matToUse->shader->set("transform", transform);
+        // Reset blend and depth state
+        glDepthMask(GL_TRUE);
+        glDisable(GL_BLEND);
 
-                    glDrawElements(
-                        GL_TRIANGLES,
-                        sub.count,
-                        GL_UNSIGNED_INT,
-                        (void*)(sub.offset * sizeof(GLuint))
-                    );
-                }
+        // === 8) Resolve MSAA ================================================
+        if (multisampleFrameBuffer) {
+            // Blitting from a multisampled framebuffer into a single sampled one resolves the samples
+            // Depth is resolved too so that the depth target stays usable after the scene pass
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, multisampleFrameBuffer);
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, postprocessFrameBuffer);
+            glBlitFramebuffer(0, 0, renderSize.x, renderSize.y, 0, 0, renderSize.x, renderSize.y,
+                GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        }
 
-                glBindVertexArray(0);
+        // === 9) Weighted blended OIT ==========================================
+        if (oitFrameBuffer && !oitCommands.empty()) {
+            // The transparent objects are drawn after the resolve since they accumulate into single sampled targets
+            // which share the resolved scene depth. The accumulation is order independent, so they are drawn unsorted.
+            glBindFramebuffer(GL_FRAMEBUFFER, oitFrameBuffer);
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            // The revealage starts at 1 (nothing covers the scene) while the sums start at 0
+            const GLfloat accumClear[] = { 0.0f, 0.0f, 0.0f, 1.0f };
+            const GLfloat weightClear[] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            glClearBufferfv(GL_COLOR, 0, accumClear);
+            glClearBufferfv(GL_COLOR, 1, weightClear);
+
+            for (const auto& cmd : oitCommands) {
+                drawCommand(cmd, VP, true);
             }
-            else {
-                // Single-material mesh
-                cmd.material->setup();
-                cmd.material->shader->use();
 
-                glm::mat4 transform = VP * cmd.localToWorld;
-                cmd.material->shader->set("transform", transform);
+            // Composite the average transparent color over the scene
+            glBindFramebuffer(GL_FRAMEBUFFER, postprocessFrameBuffer);
+            oitCompositeMaterial->setup();
+            glActiveTexture(GL_TEXTURE0);
+            oitAccumTarget->bind();
+            glActiveTexture(GL_TEXTURE1);
+            oitWeightTarget->bind();
+            oitCompositeMaterial->shader->set("accum_tex", 0);
+            oitCompositeMaterial->shader->set("weight_tex", 1);
+            glBindVertexArray(fullscreenVertexArray);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+            glActiveTexture(GL_TEXTURE0);
 
-                cmd.mesh->draw();
-            }
+            glDepthMask(GL_TRUE);
+            glDisable(GL_BLEND);
         }
 
-        // Reset blend and depth state
-        glDepthMask(GL_TRUE);
-        glDisable(GL_BLEND);
+        // === 10) Capture the Hi-Z pyramid =====================================
+        if (occlusionCulling.isEnabled()) {
+            // The depth of this frame is used to cull the objects of the next frame
+            occlusionCulling.capture(depthTarget, renderSize, VP, fullscreenVertexArray);
+            glViewport(0, 0, renderSize.x, renderSize.y);
+        }
 
-        // === 8) Postprocessing (Req 11) ======================================
+        // === 11) FXAA (only when it can't be merged into the final pass) ======
+        if (fxaaMaterial) {
+            glBindFramebuffer(GL_FRAMEBUFFER, fxaaFrameBuffer);
+            fxaaMaterial->setup();
+            fxaaMaterial->shader->set("texel_size", 1.0f / glm::vec2(renderSize));
+            glBindVertexArray(fullscreenVertexArray);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+            glBindVertexArray(0);
+        }
+
+        // === 12) Postprocessing (Req 11) =====================================
         if (postprocessMaterial) {
             // Unbind framebuffer (return to default)
             glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            // The fullscreen triangle covers the whole window, so the scene texture is upscaled by the sampler
+            glViewport(0, 0, windowSize.x, windowSize.y);
 
             // Setup postprocess material and draw fullscreen triangle
+            // The texel size is used by shaders that sample neighbouring pixels (e.g. FXAA)
             postprocessMaterial->setup();
             postprocessMaterial->shader->use();
-            glBindVertexArray(postProcessVertexArray);
+            postprocessMaterial->shader->set("texel_size", 1.0f / glm::vec2(renderSize));
+            glBindVertexArray(fullscreenVertexArray);
             glDrawArrays(GL_TRIANGLES, 0, 3);
             glBindVertexArray(0);
         }
+
+        // Stop measuring the GPU time and resize the render targets if the controller picked a new scale
+        if(dynamicResolution.endFrame()){
+            resizeRenderTargets(dynamicResolution.getRenderSize(windowSize));
+        }
     }
 
 
@@ -4,6 +4,9 @@
 #include "../components/camera.hpp"
 #include "../components/mesh-renderer.hpp"
 #include "../asset-loader.hpp"
+#include "../texture/texture-cube.hpp"
+#include "dynamic-resolution.hpp"
+#include "occlusion-culling.hpp"
 
 #include <glad/gl.h>
 #include <vector>
@@ -20,6 +23,20 @@ namespace our
         glm::vec3 center;
         Mesh* mesh;
         Material* material;
+        MeshRendererComponent* meshRenderer; // The component that issued this command
+    };
+
+    // The counters of the last rendered frame (shown in the profiler)
+    struct RenderStats {
+        // The number of levels of detail that are counted separately (coarser levels are counted with the last one)
+        static constexpr int LOD_LEVELS = 4;
+
+        int opaqueCommands = 0;         // The number of opaque commands that were drawn
+        int transparentCommands = 0;    // The number of transparent commands that were drawn (sorted or OIT)
+        int occlusionTested = 0;        // The number of commands tested against the Hi-Z pyramid
+        int occlusionCulled = 0;        // The number of tested commands that were skipped since they were hidden
+        int lodCommands[LOD_LEVELS] = {};   // The number of commands drawn at each level of detail
+        int lodTriangles[LOD_LEVELS] = {};  // The number of triangles drawn at each level of detail
     };
 
     // A forward renderer is a renderer that draw the object final color directly to the framebuffer
@@ -29,17 +46,69 @@ namespace our
     class ForwardRenderer {
         // These window size will be used on multiple occasions (setting the viewport, computing the aspect ratio, etc.)
         glm::ivec2 windowSize;
+        // The size of the offscreen render targets. It is smaller than the window size if dynamic resolution lowered the scale
+        glm::ivec2 renderSize;
         // These are two vectors in which we will store the opaque and the transparent commands.
         // We define them here (instead of being local to the "render" function) as an optimization to prevent reallocating them every frame
         std::vector<RenderCommand> opaqueCommands;
         std::vector<RenderCommand> transparentCommands;
-        // Objects used for rendering a skybox
-        Mesh* skySphere;
-        TexturedMaterial* skyMaterial;
+        // The transparent commands drawn by the weighted blended OIT pass (they don't need sorting)
+        std::vector<RenderCommand> oitCommands;
+        // An empty vertex array used to draw fullscreen triangles (the sky and the postprocessing passes)
+        GLuint fullscreenVertexArray = 0;
+        // Objects used for rendering the sky
+        // The sky is a fullscreen triangle on the far plane that samples either an equirectangular texture or a cube map
+        Material* skyMaterial = nullptr;
+        Texture2D* skyTexture = nullptr;
+        TextureCube* skyCubemap = nullptr;
+        Sampler* skySampler = nullptr;
         // Objects used for Postprocessing
-        GLuint postprocessFrameBuffer, postProcessVertexArray;
-        Texture2D *colorTarget, *depthTarget;
-        TexturedMaterial* postprocessMaterial;
+        // The postprocess material also exists (with a plain blit shader) if dynamic resolution needs the offscreen framebuffer
+        GLuint postprocessFrameBuffer = 0;
+        Texture2D *colorTarget = nullptr, *depthTarget = nullptr;
+        TexturedMaterial* postprocessMaterial = nullptr;
+        // Objects used for anti-aliasing
+        // With MSAA, the scene is drawn into multisampled renderbuffers which are resolved into the color & depth targets
+        int msaaSamples = 0;
+        GLuint multisampleFrameBuffer = 0, multisampleColorBuffer = 0, multisampleDepthBuffer = 0;
+        // FXAA is merged into the final pass unless a postprocessing effect exists, in which case it gets its own pass and target
+        GLuint fxaaFrameBuffer = 0;
+        Texture2D* fxaaTarget = nullptr;
+        TexturedMaterial* fxaaMaterial = nullptr;
+        // Objects used for weighted blended order-independent transparency (OIT)
+        // The transparent objects accumulate into these targets (sharing the scene depth) which are then composited over the scene
+        bool orderIndependentTransparency = false;
+        GLuint oitFrameBuffer = 0;
+        Texture2D *oitAccumTarget = nullptr, *oitWeightTarget = nullptr;
+        Material* oitCompositeMaterial = nullptr;
+        // Scales the offscreen render targets based on the GPU frame time
+        DynamicResolution dynamicResolution;
+        // Skips the commands hidden behind the depth of the previous frame
+        OcclusionCulling occlusionCulling;
+        // The counters of the last rendered frame
+        RenderStats stats;
+        // Options used to pick the levels of detail
+        // The hysteresis is the half width of the band (relative to each threshold) in which the current level is kept
+        // The bias scales the projected sizes (values above 1 keep the finer levels for longer)
+        float lodHysteresis = 0.1f;
+        float lodBias = 1.0f;
+
+        // Creates the color & depth targets (and the anti-aliasing targets if needed) with the given size
+        // and attaches them to their framebuffers
+        void createRenderTargets(glm::ivec2 size);
+        // Deletes the color & depth targets (and the anti-aliasing targets)
+        void destroyRenderTargets();
+        // Recreates all the render targets with the given size
+        void resizeRenderTargets(glm::ivec2 size);
+        // Draws the mesh of the given command (using the materials of its submeshes if it has any)
+        // In the OIT pass, the blending state of the materials is replaced by the one needed for the accumulation
+        void drawCommand(const RenderCommand& command, const glm::mat4& VP, bool oitPass);
+        // Returns the material each submesh of the mesh is drawn with (the .mtl material or the one of the command)
+        static const Material* getSubmeshMaterial(const RenderCommand& command, const Mesh::Submesh& submesh);
+        // Returns true if all the materials the command is drawn with can be drawn in the OIT pass
+        static bool supportsOIT(const RenderCommand& command);
+        // Picks the level of detail of the given command from the projected size of its bounding sphere and replaces its mesh
+        void selectLevelOfDetail(RenderCommand& command, const CameraComponent* camera, const glm::vec3& cameraPosition);
     public:
         // Initialize the renderer including the sky and the Postprocessing objects.
         // windowSize is the width & height of the window (in pixels).
@@ -49,6 +118,10 @@ namespace our
         // This function should be called every frame to draw the given world
         void render(World* world);
 
+        // Returns the dynamic resolution controller (to read the current scale and GPU frame time)
+        const DynamicResolution& getDynamicResolution() const { return dynamicResolution; }
+        // Returns the counters of the last rendered frame
+        const RenderStats& getStats() const { return stats; }
 
     };
 
@@ -30,14 +30,15 @@ namespace our
         // This should be called every frame to update all entities containing a FreeCameraControllerComponent 
         void update(World* world, float deltaTime) {
             // First of all, we search for an entity containing both a CameraComponent and a FreeCameraControllerComponent
-            // As soon as we find one, we break
+            // We only use the first one we find
             CameraComponent* camera = nullptr;
             FreeCameraControllerComponent *controller = nullptr;
-            for(auto entity : world->getEntities()){
-                camera = entity->getComponent<CameraComponent>();
-                controller = entity->getComponent<FreeCameraControllerComponent>();
-                if(camera && controller) break;
-            }
+            world->view<FreeCameraControllerComponent, CameraComponent>().forEach(
+                [&](Entity*, FreeCameraControllerComponent* foundController, CameraComponent* foundCamera){
+                    if(camera) return;
+                    camera = foundCamera;
+                    controller = foundController;
+                });
             // If there is no entity with both a CameraComponent and a FreeCameraControllerComponent, we can do nothing so we return
             if(!(camera && controller)) return;
             // Get the entity that we found via getOwner of camera (we could use controller->getOwner())
@@ -54,8 +55,9 @@ namespace our
             }
 
             // We get a reference to the entity's position and rotation
-            glm::vec3& position = entity->localTransform.position;
-            glm::vec3& rotation = entity->localTransform.rotation;
+            Transform& transform = entity->editLocalTransform();
+            glm::vec3& position = transform.position;
+            glm::vec3 rotation = transform.getEulerRotation();
 
             // If the left mouse button is pressed, we get the change in the mouse location
             // and use it to update the camera rotation
@@ -71,18 +73,17 @@ namespace our
             // This is not necessary, but whenever the rotation goes outside the 0 to 2*PI range, we wrap it back inside.
             // This could prevent floating point error if the player rotates in single direction for an extremely long time. 
             rotation.y = glm::wrapAngle(rotation.y);
+            transform.setEulerRotation(rotation);
 
             // We update the camera fov based on the mouse wheel scrolling amount
             float fov = camera->fovY + app->getMouse().getScrollOffset().y * controller->fovSensitivity;
             fov = glm::clamp(fov, glm::pi<float>() * 0.01f, glm::pi<float>() * 0.99f); // We keep the fov in the range 0.01*PI to 0.99*PI
             camera->fovY = fov;
 
-            // We get the camera model matrix (relative to its parent) to compute the front, up and right directions
-            glm::mat4 matrix = entity->localTransform.toMat4();
-
-            glm::vec3 front = glm::vec3(matrix * glm::vec4(0, 0, -1, 0)),
-                      up = glm::vec3(matrix * glm::vec4(0, 1, 0, 0)), 
-                      right = glm::vec3(matrix * glm::vec4(1, 0, 0, 0));
+            // We get the front, up and right directions of the camera (relative to its parent) from its transform
+            glm::vec3 front = transform.getForward(),
+                      up = transform.getUp(),
+                      right = transform.getRight();
 
             glm::vec3 current_sensitivity = controller->positionSensitivity;
             // If the LEFT SHIFT key is pressed, we multiply the position sensitivity by the speed up factor
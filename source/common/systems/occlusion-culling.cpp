@@ -0,0 +1,219 @@
+#include "occlusion-culling.hpp"
+#include "../texture/texture-utils.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+
+namespace our {
+
+    void OcclusionCulling::initialize(const nlohmann::json& config){
+        enabled = false;
+        if(!config.is_object()) return;
+        enabled = config.value("enabled", true);
+        baseWidth = glm::max(config.value("width", baseWidth), 16);
+        depthBias = config.value("depthBias", depthBias);
+        if(!enabled) return;
+
+        glGenFramebuffers(1, &frameBuffer);
+        for(auto& readback : readbacks) glGenBuffers(1, &readback.pixelBuffer);
+        currentReadback = 0;
+        hasPyramid = false;
+
+        // The shader that writes the farthest depth of the pixels covered by each texel of the base
+        downsampleShader = new ShaderProgram();
+        downsampleShader->attach("assets/shaders/fullscreen.vert", GL_VERTEX_SHADER);
+        downsampleShader->attach("assets/shaders/hi-z-downsample.frag", GL_FRAGMENT_SHADER);
+        downsampleShader->link();
+    }
+
+    void OcclusionCulling::destroy(){
+        if(!enabled) return;
+        for(auto& readback : readbacks){
+            if(readback.fence) glDeleteSync(readback.fence);
+            glDeleteBuffers(1, &readback.pixelBuffer);
+            readback = Readback();
+        }
+        glDeleteFramebuffers(1, &frameBuffer);
+        frameBuffer = 0;
+        delete baseTarget;
+        baseTarget = nullptr;
+        baseSize = glm::ivec2(0);
+        delete downsampleShader;
+        downsampleShader = nullptr;
+        levels.clear();
+        levelSizes.clear();
+        hasPyramid = false;
+        enabled = false;
+    }
+
+    void OcclusionCulling::resizeBase(glm::ivec2 renderSize){
+        glm::ivec2 size = glm::ivec2(baseWidth, glm::max(1, (int)(baseWidth * (float)renderSize.y / renderSize.x + 0.5f)));
+        if(size == baseSize) return;
+        baseSize = size;
+
+        delete baseTarget;
+        baseTarget = texture_utils::empty(GL_R32F, baseSize);
+        glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, baseTarget->getOpenGLName(), 0);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE){
+            std::cerr << "ERROR: Hi-Z framebuffer is not complete" << std::endl;
+        }
+    }
+
+    void OcclusionCulling::beginFrame(){
+        if(!enabled) return;
+        // Look for the newest readback that the GPU finished. The slots are checked from the oldest (the next one to be written)
+        // to the newest since the GPU finishes them in order, and the search stops at the first one that is not ready yet.
+        Readback* newest = nullptr;
+        for(int offset = 0; offset < BUFFER_COUNT; ++offset){
+            Readback& readback = readbacks[(currentReadback + offset) % BUFFER_COUNT];
+            if(!readback.fence) continue;
+            GLenum status = glClientWaitSync(readback.fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+            glDeleteSync(readback.fence);
+            readback.fence = nullptr;
+            newest = &readback;
+        }
+        if(newest) buildPyramid(*newest);
+    }
+
+    void OcclusionCulling::buildPyramid(Readback& readback){
+        // Rebuild the level sizes if the base size changed
+        if(levelSizes.empty() || levelSizes[0] != readback.size){
+            levelSizes.clear();
+            levels.clear();
+            glm::ivec2 size = readback.size;
+            while(true){
+                levelSizes.push_back(size);
+                levels.emplace_back(size.x * size.y);
+                if(size.x == 1 && size.y == 1) break;
+                size = glm::max((size + 1) / 2, glm::ivec2(1));
+            }
+        }
+
+        // Copy the base from the pixel buffer
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+        size_t bytes = levels[0].size() * sizeof(float);
+        const void* data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+        if(!data){
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            return;
+        }
+        std::copy_n(static_cast<const float*>(data), levels[0].size(), levels[0].data());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        // Each texel of a level holds the farthest depth of the (up to) 2x2 texels it covers in the previous level
+        for(size_t level = 1; level < levels.size(); ++level){
+            const std::vector<float>& source = levels[level - 1];
+            glm::ivec2 sourceSize = levelSizes[level - 1];
+            std::vector<float>& target = levels[level];
+            glm::ivec2 targetSize = levelSizes[level];
+            for(int y = 0; y < targetSize.y; ++y){
+                int y0 = 2 * y, y1 = glm::min(2 * y + 1, sourceSize.y - 1);
+                for(int x = 0; x < targetSize.x; ++x){
+                    int x0 = 2 * x, x1 = glm::min(2 * x + 1, sourceSize.x - 1);
+                    float farthest = 0.0f;
+                    for(int sy = y0; sy <= y1; ++sy)
+                        for(int sx = x0; sx <= x1; ++sx)
+                            farthest = glm::max(farthest, source[sy * sourceSize.x + sx]);
+                    target[y * targetSize.x + x] = farthest;
+                }
+            }
+        }
+
+        viewProjection = readback.viewProjection;
+        hasPyramid = true;
+    }
+
+    bool OcclusionCulling::isOccluded(const glm::mat4& localToWorld, const glm::vec3& boundsMin, const glm::vec3& boundsMax) const {
+        if(!enabled || !hasPyramid) return false;
+
+        // Project the corners of the box to find its screen rectangle and its nearest depth
+        glm::mat4 MVP = viewProjection * localToWorld;
+        glm::vec2 rectMin = glm::vec2(std::numeric_limits<float>::max()), rectMax = -rectMin;
+        float nearestDepth = 1.0f;
+        for(int corner = 0; corner < 8; ++corner){
+            glm::vec3 position = glm::vec3(
+                (corner & 1) ? boundsMax.x : boundsMin.x,
+                (corner & 2) ? boundsMax.y : boundsMin.y,
+                (corner & 4) ? boundsMax.z : boundsMin.z
+            );
+            glm::vec4 clip = MVP * glm::vec4(position, 1.0f);
+            // If the box crosses the near plane, it covers the camera so we can't say that it is hidden
+            if(clip.w <= 1e-5f) return false;
+            glm::vec3 ndc = glm::vec3(clip) / clip.w;
+            rectMin = glm::min(rectMin, glm::vec2(ndc));
+            rectMax = glm::max(rectMax, glm::vec2(ndc));
+            nearestDepth = glm::min(nearestDepth, ndc.z * 0.5f + 0.5f);
+        }
+        // Boxes outside the captured view have no occluders in the pyramid
+        if(rectMax.x < -1.0f || rectMax.y < -1.0f || rectMin.x > 1.0f || rectMin.y > 1.0f) return false;
+
+        // Find the rectangle of base texels covered by the box
+        glm::ivec2 size = levelSizes[0];
+        glm::vec2 uvMin = glm::clamp(rectMin * 0.5f + 0.5f, 0.0f, 1.0f);
+        glm::vec2 uvMax = glm::clamp(rectMax * 0.5f + 0.5f, 0.0f, 1.0f);
+        glm::ivec2 texelMin = glm::min(glm::ivec2(uvMin * glm::vec2(size)), size - 1);
+        glm::ivec2 texelMax = glm::min(glm::ivec2(uvMax * glm::vec2(size)), size - 1);
+
+        // Go up the pyramid till the rectangle covers at most 2x2 texels
+        // The texels of higher levels cover their children, so the test stays conservative
+        size_t level = 0;
+        while(level + 1 < levels.size() && glm::max(texelMax.x - texelMin.x, texelMax.y - texelMin.y) > 1){
+            texelMin /= 2;
+            texelMax /= 2;
+            ++level;
+            texelMax = glm::min(texelMax, levelSizes[level] - 1);
+        }
+
+        // The box is hidden if it is behind the farthest occluder under its rectangle
+        const std::vector<float>& depths = levels[level];
+        int width = levelSizes[level].x;
+        float farthest = 0.0f;
+        for(int y = texelMin.y; y <= texelMax.y; ++y)
+            for(int x = texelMin.x; x <= texelMax.x; ++x)
+                farthest = glm::max(farthest, depths[y * width + x]);
+        return nearestDepth - depthBias > farthest;
+    }
+
+    void OcclusionCulling::capture(Texture2D* depthTarget, glm::ivec2 renderSize, const glm::mat4& viewProjection, GLuint fullscreenVertexArray){
+        if(!enabled || !depthTarget) return;
+        resizeBase(renderSize);
+
+        // Reduce the depth target into the base
+        glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+        glViewport(0, 0, baseSize.x, baseSize.y);
+        glDisable(GL_DEPTH_TEST);
+        glDisable(GL_BLEND);
+        glDisable(GL_CULL_FACE);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        downsampleShader->use();
+        glActiveTexture(GL_TEXTURE0);
+        depthTarget->bind();
+        glBindSampler(0, 0);
+        downsampleShader->set("depth_tex", 0);
+        downsampleShader->set("source_size", glm::vec2(renderSize));
+        downsampleShader->set("target_size", glm::vec2(baseSize));
+        glBindVertexArray(fullscreenVertexArray);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+
+        // Start copying the base into a pixel buffer. If the slot is still in flight, its result is dropped.
+        Readback& readback = readbacks[currentReadback];
+        if(readback.fence) glDeleteSync(readback.fence);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBuffer);
+        if(readback.size != baseSize){
+            glBufferData(GL_PIXEL_PACK_BUFFER, baseSize.x * baseSize.y * sizeof(float), nullptr, GL_STREAM_READ);
+            readback.size = baseSize;
+        }
+        glReadBuffer(GL_COLOR_ATTACHMENT0);
+        glReadPixels(0, 0, baseSize.x, baseSize.y, GL_RED, GL_FLOAT, nullptr);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readback.viewProjection = viewProjection;
+        currentReadback = (currentReadback + 1) % BUFFER_COUNT;
+    }
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../shader/shader.hpp"
+#include "../texture/texture2d.hpp"
+
+#include <glad/gl.h>
+#include <glm/glm.hpp>
+#include <json/json.hpp>
+#include <vector>
+
+namespace our {
+
+    // Occlusion culling skips the objects that are hidden behind other objects using a hierarchical depth (Hi-Z) pyramid.
+    // After the scene is drawn, its depth is reduced on the GPU into a small texture where each texel holds the farthest depth
+    // of the pixels it covers. The texture is read back asynchronously (through pixel buffers and fences) so the CPU never waits
+    // for the GPU, which means that the pyramid is one frame late. The rest of the pyramid levels are built on the CPU.
+    // An object is occluded if the nearest depth of its bounding box is farther than the farthest depth under the box.
+    // Since the pyramid was captured by the previous frame, the boxes are projected using the view projection of that frame.
+    class OcclusionCulling {
+        // The number of pixel buffers that can be in flight at the same time
+        static constexpr int BUFFER_COUNT = 3;
+        struct Readback {
+            GLuint pixelBuffer = 0;
+            GLsync fence = nullptr;         // Signaled when the GPU finishes copying into the pixel buffer
+            glm::ivec2 size = glm::ivec2(0);
+            glm::mat4 viewProjection = glm::mat4(1.0f);
+        };
+        Readback readbacks[BUFFER_COUNT];
+        int currentReadback = 0;
+
+        bool enabled = false;
+        int baseWidth = 256;                // The width of the pyramid base (the height follows the aspect ratio of the render target)
+        float depthBias = 0.0001f;          // Objects must be farther than the occluders by this depth to be culled
+
+        // The GPU objects used to reduce the depth target into the pyramid base
+        GLuint frameBuffer = 0;
+        Texture2D* baseTarget = nullptr;
+        glm::ivec2 baseSize = glm::ivec2(0);
+        ShaderProgram* downsampleShader = nullptr;
+
+        // The pyramid levels on the CPU (level 0 is the base) and the view projection matrix used to draw the captured depth
+        std::vector<std::vector<float>> levels;
+        std::vector<glm::ivec2> levelSizes;
+        glm::mat4 viewProjection = glm::mat4(1.0f);
+        bool hasPyramid = false;
+
+        // Recreates the base target if the render size requires a different base size
+        void resizeBase(glm::ivec2 renderSize);
+        // Copies the given readback into the pyramid base and builds the rest of the levels
+        void buildPyramid(Readback& readback);
+    public:
+        // Reads the options from the "occlusionCulling" object of the renderer configuration and creates the GPU objects
+        // The object can contain: "enabled", "width", "depthBias"
+        void initialize(const nlohmann::json& config);
+        // Deletes the GPU objects
+        void destroy();
+
+        bool isEnabled() const { return enabled; }
+
+        // Collects the newest readback that the GPU finished (if any) and rebuilds the pyramid from it
+        void beginFrame();
+        // Returns true if the given local space box (transformed by localToWorld) is hidden according to the pyramid
+        bool isOccluded(const glm::mat4& localToWorld, const glm::vec3& boundsMin, const glm::vec3& boundsMax) const;
+        // Reduces the given depth target into the pyramid base and starts reading it back
+        // viewProjection is the matrix used to draw the depth, and the vertex array is used to draw a fullscreen triangle
+        // Note: this changes the framebuffer binding and the viewport
+        void capture(Texture2D* depthTarget, glm::ivec2 renderSize, const glm::mat4& viewProjection, GLuint fullscreenVertexArray);
+    };
+
+}
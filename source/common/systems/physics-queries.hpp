@@ -0,0 +1,77 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+namespace our {
+
+    class BulletColliderComponent;
+    class PhysicsSystem;
+
+    // The result of a ray or sweep query
+    struct QueryHit {
+        bool hit = false;
+        float fraction = 1.0f;                      // How far along the query the hit is (0 = at the start, 1 = at the end)
+        glm::vec3 point = glm::vec3(0.0f);
+        glm::vec3 normal = glm::vec3(0.0f);
+        BulletColliderComponent* collider = nullptr;
+    };
+
+    // A batch of queries that are run together by "PhysicsSystem::runQueries" (the rays and sweeps possibly in parallel).
+    // Gameplay code adds its rays (line of sight, gunfire), sphere sweeps (footsteps, projectiles) and sphere overlaps,
+    // the batch is run once per frame and the results are read back by the indices returned when the queries were added.
+    // Clearing the batch keeps its memory, so a batch that is reused every frame doesn't allocate.
+    // Each query has a mask of the collision groups it can hit (-1 = all of them).
+    class PhysicsQueryBatch {
+    public:
+        explicit PhysicsQueryBatch(size_t maxOverlapResults = 16) : maxOverlapResults(maxOverlapResults) {}
+
+        // Each function returns the index of the query in its kind
+        size_t addRay(const glm::vec3& from, const glm::vec3& to, int mask = -1) {
+            rays.push_back({from, to, 0.0f, mask});
+            return rays.size() - 1;
+        }
+        size_t addSweep(const glm::vec3& from, const glm::vec3& to, float radius, int mask = -1) {
+            sweeps.push_back({from, to, radius, mask});
+            return sweeps.size() - 1;
+        }
+        size_t addOverlap(const glm::vec3& center, float radius, int mask = -1) {
+            overlaps.push_back({center, center, radius, mask});
+            return overlaps.size() - 1;
+        }
+
+        // The closest hit of each ray and sweep
+        const QueryHit& getRayHit(size_t index) const { return rayHits[index]; }
+        const QueryHit& getSweepHit(size_t index) const { return sweepHits[index]; }
+        // The colliders overlapping each sphere (at most "maxOverlapResults" of them)
+        size_t getOverlapCount(size_t index) const { return overlapCounts[index]; }
+        BulletColliderComponent* getOverlap(size_t index, size_t result) const { return overlapResults[index * maxOverlapResults + result]; }
+
+        size_t getRayCount() const { return rays.size(); }
+        size_t getSweepCount() const { return sweeps.size(); }
+        size_t getOverlapQueryCount() const { return overlaps.size(); }
+
+        // Removes all the queries and their results (the memory is kept for the next batch)
+        void clear() {
+            rays.clear(); sweeps.clear(); overlaps.clear();
+            rayHits.clear(); sweepHits.clear(); overlapCounts.clear(); overlapResults.clear();
+        }
+
+    private:
+        friend class PhysicsSystem;
+
+        struct Query {
+            glm::vec3 from, to;     // The center of an overlap is stored in both
+            float radius;
+            int mask;
+        };
+
+        size_t maxOverlapResults;
+        std::vector<Query> rays, sweeps, overlaps;
+        std::vector<QueryHit> rayHits, sweepHits;
+        std::vector<size_t> overlapCounts;
+        std::vector<BulletColliderComponent*> overlapResults;  // "maxOverlapResults" slots for each overlap query
+    };
+
+}
@@ -1,6 +1,11 @@
 #include "physics-system.hpp"
 #include "../components/bullet-collider.hpp"
+#include "convex-decomposition.hpp"
+#include "../threading/thread-pool.hpp"
+#include <BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h>
+#include <BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h>
 #include <iostream>
+#include <algorithm>
 
 namespace our {
 
@@ -11,54 +16,103 @@ namespace our {
     }
 
     PhysicsSystem::~PhysicsSystem() {
+        destroy();
+    }
+
+    void PhysicsSystem::destroy() {
+        if (world) world->removeRemovalListener(removalListener);
+        world = nullptr;
         // Clean up in reverse order of creation
         if (dynamicsWorld) {
             // Remove all rigid bodies
+            // They are owned (and deleted) by their collider components, so we only take them out of the dynamics world
             for (int i = dynamicsWorld->getNumCollisionObjects() - 1; i >= 0; i--) {
                 btCollisionObject* obj = dynamicsWorld->getCollisionObjectArray()[i];
-                btRigidBody* body = btRigidBody::upcast(obj);
-                if (body && body->getMotionState()) {
-                    delete body->getMotionState();
-                }
                 dynamicsWorld->removeCollisionObject(obj);
-                delete obj;
             }
             delete dynamicsWorld;
         }
         
+        if (solverPool) delete solverPool;
         if (solver) delete solver;
         if (overlappingPairCache) delete overlappingPairCache;
         if (dispatcher) delete dispatcher;
         if (collisionConfiguration) delete collisionConfiguration;
+        dynamicsWorld = nullptr;
+        solverPool = nullptr;
+        solver = nullptr;
+        overlappingPairCache = nullptr;
+        dispatcher = nullptr;
+        collisionConfiguration = nullptr;
+
+        // Give Bullet back its own scheduler before ours is deleted
+        if (taskScheduler) {
+            if (btGetTaskScheduler() == taskScheduler.get()) btSetTaskScheduler(btGetSequentialTaskScheduler());
+            taskScheduler.reset();
+        }
+
+        colliders.clear();
+        events.clear();
+        touching.clear();
+        // The shapes still used by live colliders stay alive, only the cache entries are dropped
+        shapeCache.clear();
+        convex_decomposition::clearMemoryCache();
     }
 
-    void PhysicsSystem::initialize(const glm::vec3& gravityVec) {
-        // Create collision configuration
-        collisionConfiguration = new btDefaultCollisionConfiguration();
-        
-        // Create collision dispatcher
-        dispatcher = new btCollisionDispatcher(collisionConfiguration);
-        
-        // Create broadphase
-        overlappingPairCache = new btDbvtBroadphase();
-        
-        // Create constraint solver
-        solver = new btSequentialImpulseConstraintSolver();
-        
-        // Create dynamics world
-        dynamicsWorld = new btDiscreteDynamicsWorld(
-            dispatcher, overlappingPairCache, solver, collisionConfiguration
-        );
+    void PhysicsSystem::initialize(const glm::vec3& gravityVec, const nlohmann::json& config) {
+        // Entering the state again must not leak the previous physics world
+        destroy();
+        accumulator = 0.0f;
+        setGravity(gravityVec);
+        configure(config);
+
+        if (multithreaded) {
+            // The task scheduler must be installed before the world is created
+            taskScheduler = std::make_unique<BulletTaskScheduler>();
+            btSetTaskScheduler(taskScheduler.get());
+
+            // The threads create manifolds and collision algorithms concurrently, so the pools are made bigger
+            btDefaultCollisionConstructionInfo constructionInfo;
+            constructionInfo.m_defaultMaxPersistentManifoldPoolSize = 80000;
+            constructionInfo.m_defaultMaxCollisionAlgorithmPoolSize = 80000;
+            collisionConfiguration = new btDefaultCollisionConfiguration(constructionInfo);
+            dispatcher = new btCollisionDispatcherMt(collisionConfiguration, 40);
+            overlappingPairCache = new btDbvtBroadphase();
+            // Each island is solved by one of the pooled solvers, the big islands are solved by the multithreaded solver
+            solverPool = new btConstraintSolverPoolMt(taskScheduler->getNumThreads());
+            solver = new btSequentialImpulseConstraintSolverMt();
+            dynamicsWorld = new btDiscreteDynamicsWorldMt(
+                dispatcher, overlappingPairCache, solverPool, solver, collisionConfiguration
+            );
+            std::cout << "PhysicsSystem: Multithreaded dynamics world on " << taskScheduler->getNumThreads() << " threads" << std::endl;
+        } else {
+            // Create collision configuration
+            collisionConfiguration = new btDefaultCollisionConfiguration();
+            
+            // Create collision dispatcher
+            dispatcher = new btCollisionDispatcher(collisionConfiguration);
+            
+            // Create broadphase
+            overlappingPairCache = new btDbvtBroadphase();
+            
+            // Create constraint solver
+            solver = new btSequentialImpulseConstraintSolver();
+            
+            // Create dynamics world
+            dynamicsWorld = new btDiscreteDynamicsWorld(
+                dispatcher, overlappingPairCache, solver, collisionConfiguration
+            );
+        }
         
         // Set gravity
-        setGravity(gravityVec);
+        dynamicsWorld->setGravity(gravity);
     }
 
     void PhysicsSystem::registerCollider(BulletColliderComponent* collider) {
         if (!collider || !dynamicsWorld) return;
         
         // Initialize the collider with the dynamics world
-        collider->initialize(dynamicsWorld);
+        collider->initialize(dynamicsWorld, &shapeCache);
         
         // Track it
         colliders.push_back(collider);
@@ -77,6 +131,37 @@ namespace our {
         if (it != colliders.end()) {
             colliders.erase(it);
         }
+        forgetContacts({collider});
+    }
+
+    void PhysicsSystem::removeColliders(const std::vector<BulletColliderComponent*>& removed) {
+        if (removed.empty() || !dynamicsWorld) return;
+
+        for (auto* collider : removed) {
+            if (collider->rigidBody) {
+                dynamicsWorld->removeRigidBody(collider->rigidBody);
+            }
+        }
+
+        // Drop all the removed colliders from the tracking list in a single pass
+        std::vector<BulletColliderComponent*> sorted = removed;
+        std::sort(sorted.begin(), sorted.end());
+        colliders.erase(std::remove_if(colliders.begin(), colliders.end(), [&](BulletColliderComponent* collider){
+            return std::binary_search(sorted.begin(), sorted.end(), collider);
+        }), colliders.end());
+        forgetContacts(sorted);
+    }
+
+    void PhysicsSystem::forgetContacts(const std::vector<BulletColliderComponent*>& sortedRemoved) {
+        // The removed components may be deleted already, so their pairs must not show up in an END event
+        touching.erase(std::remove_if(touching.begin(), touching.end(), [&](const auto& pair){
+            return std::binary_search(sortedRemoved.begin(), sortedRemoved.end(), pair.first) ||
+                   std::binary_search(sortedRemoved.begin(), sortedRemoved.end(), pair.second);
+        }), touching.end());
+        events.erase(std::remove_if(events.begin(), events.end(), [&](const CollisionEvent& event){
+            return std::binary_search(sortedRemoved.begin(), sortedRemoved.end(), event.first) ||
+                   std::binary_search(sortedRemoved.begin(), sortedRemoved.end(), event.second);
+        }), events.end());
     }
 
     void PhysicsSystem::syncFromEntities() {
@@ -89,16 +174,121 @@ namespace our {
     }
 
     void PhysicsSystem::update(float deltaTime) {
+        step(deltaTime);
+        syncToEntities();
+    }
+
+    void PhysicsSystem::configure(const nlohmann::json& config) {
+        if (!config.is_object()) return;
+        float stepRate = config.value("stepRate", 1.0f / fixedTimeStep);
+        if (stepRate > 0.0f) fixedTimeStep = 1.0f / stepRate;
+        maxSubSteps = std::max(1, config.value("maxSubSteps", maxSubSteps));
+        interpolate = config.value("interpolate", interpolate);
+        multithreaded = config.value("multithreaded", multithreaded);
+        if (config.contains("gravity") && config["gravity"].is_array() && config["gravity"].size() >= 3) {
+            auto& value = config["gravity"];
+            setGravity(glm::vec3(value[0].get<float>(), value[1].get<float>(), value[2].get<float>()));
+        }
+    }
+
+    void PhysicsSystem::step(float deltaTime) {
+        events.clear();
+        if (!dynamicsWorld) return;
+
+        // A frame spike would otherwise make the next frames even longer (each one has to simulate more steps),
+        // so the time beyond the step budget is dropped and the simulation slows down instead
+        accumulator = std::min(accumulator + deltaTime, maxSubSteps * fixedTimeStep);
+        while (accumulator >= fixedTimeStep) {
+            // Keep the transforms before the step to interpolate from them
+            if (interpolate) {
+                for (auto* collider : colliders) {
+                    if (collider->rigidBody && collider->mass > 0.0f) collider->previousTransform = collider->rigidBody->getWorldTransform();
+                }
+            }
+            // No sub steps since we split the time ourselves (Bullet's own interpolation would be applied otherwise)
+            dynamicsWorld->stepSimulation(fixedTimeStep, 0);
+            collectEvents();
+            accumulator -= fixedTimeStep;
+        }
+    }
+
+    void PhysicsSystem::collectEvents() {
+        // Find the reported pairs that touch after this step
+        // A manifold exists as long as the bodies' bounding boxes overlap, so the pair only touches if one of its points is in contact
+        currentContacts.clear();
+        int manifoldCount = dispatcher->getNumManifolds();
+        for (int i = 0; i < manifoldCount; i++) {
+            btPersistentManifold* manifold = dispatcher->getManifoldByIndexInternal(i);
+            auto* first = static_cast<BulletColliderComponent*>(manifold->getBody0()->getUserPointer());
+            auto* second = static_cast<BulletColliderComponent*>(manifold->getBody1()->getUserPointer());
+            if (!first || !second) continue;
+            bool trigger = first->isTrigger || second->isTrigger;
+            if (!trigger && !first->reportContacts && !second->reportContacts) continue;
+
+            int deepest = -1;
+            btScalar deepestDistance = btScalar(0);
+            for (int j = 0; j < manifold->getNumContacts(); j++) {
+                btScalar distance = manifold->getContactPoint(j).getDistance();
+                if (distance <= deepestDistance) {
+                    deepest = j;
+                    deepestDistance = distance;
+                }
+            }
+            if (deepest < 0) continue;
+
+            const btManifoldPoint& point = manifold->getContactPoint(deepest);
+            glm::vec3 normal(point.m_normalWorldOnB.x(), point.m_normalWorldOnB.y(), point.m_normalWorldOnB.z());
+            // The normal points from the second body to the first, so it is flipped with the pair
+            if (second < first) {
+                std::swap(first, second);
+                normal = -normal;
+            }
+            CollisionEvent contact{CollisionEvent::Type::BEGIN, first, second, trigger};
+            contact.point = glm::vec3(point.m_positionWorldOnB.x(), point.m_positionWorldOnB.y(), point.m_positionWorldOnB.z());
+            contact.normal = normal;
+            currentContacts.push_back(contact);
+        }
+
+        // A compound or a pair with several manifolds may be found more than once, only its first contact is kept
+        std::sort(currentContacts.begin(), currentContacts.end(), [](const CollisionEvent& a, const CollisionEvent& b){
+            return std::make_pair(a.first, a.second) < std::make_pair(b.first, b.second);
+        });
+        currentContacts.erase(std::unique(currentContacts.begin(), currentContacts.end(), [](const CollisionEvent& a, const CollisionEvent& b){
+            return a.first == b.first && a.second == b.second;
+        }), currentContacts.end());
+
+        // Diff the touching pairs against the previous step (both lists are sorted)
+        currentTouching.clear();
+        size_t previous = 0;
+        for (auto& contact : currentContacts) {
+            auto pair = std::make_pair(contact.first, contact.second);
+            while (previous < touching.size() && touching[previous] < pair) {
+                events.push_back({CollisionEvent::Type::END, touching[previous].first, touching[previous].second,
+                                  touching[previous].first->isTrigger || touching[previous].second->isTrigger});
+                previous++;
+            }
+            if (previous < touching.size() && touching[previous] == pair) {
+                contact.type = CollisionEvent::Type::STAY;
+                previous++;
+            }
+            events.push_back(contact);
+            currentTouching.push_back(pair);
+        }
+        for (; previous < touching.size(); previous++) {
+            events.push_back({CollisionEvent::Type::END, touching[previous].first, touching[previous].second,
+                              touching[previous].first->isTrigger || touching[previous].second->isTrigger});
+        }
+        touching.swap(currentTouching);
+    }
+
+    void PhysicsSystem::syncToEntities() {
         if (!dynamicsWorld) return;
-        
-        // Step the physics simulation
-        // Parameters: timeStep, maxSubSteps, fixedTimeStep
-        dynamicsWorld->stepSimulation(deltaTime, 10, 1.0f / 60.0f);
         
         // Sync physics transforms back to entities
+        float interpolation = getInterpolation();
         for (auto* collider : colliders) {
             if (collider && collider->mass > 0.0f) {
-                collider->syncToEntity();
+                collider->syncToEntity(interpolation);
             }
         }
     }
@@ -108,24 +298,38 @@ namespace our {
         
         std::cout << "PhysicsSystem: Registering colliders from world..." << std::endl;
         int colliderCount = 0;
-        
-        // Iterate through all entities and register colliders
-        for (auto* entity : world->getEntities()) {
-            if (!entity) continue;
-            
-            // Check if entity has a BulletColliderComponent
-            auto* collider = entity->getComponent<BulletColliderComponent>();
-            if (collider) {
-                std::cout << "  Found collider on entity: " << entity->name << std::endl;
-                registerCollider(collider);
-                colliderCount++;
+
+        // Decompose the meshes of the decomposed colliders in parallel first (each mesh once), the colliders then find them in the cache
+        std::vector<const Mesh*> decomposedMeshes;
+        world->forEach<BulletColliderComponent>([&](BulletColliderComponent* collider) {
+            if (collider->shapeType == CollisionShape::DECOMPOSED && collider->mesh &&
+                std::find(decomposedMeshes.begin(), decomposedMeshes.end(), collider->mesh) == decomposedMeshes.end()) {
+                decomposedMeshes.push_back(collider->mesh);
             }
-            
-            // Recursively check children
-            // Note: You'd need to implement a method to get all descendants
-        }
+        });
+        ThreadPool::getShared().parallelFor(0, decomposedMeshes.size(), 1, [&](size_t first, size_t last) {
+            for (size_t index = first; index < last; ++index) convex_decomposition::get(*decomposedMeshes[index]);
+        });
+        
+        // Iterate through all the colliders in the world (including the ones on child entities) and register them
+        world->forEach<BulletColliderComponent>([&](BulletColliderComponent* collider) {
+            std::cout << "  Found collider on entity: " << collider->getOwner()->name << std::endl;
+            registerCollider(collider);
+            colliderCount++;
+        });
         
-        std::cout << "PhysicsSystem: Registered " << colliderCount << " colliders" << std::endl;
+        std::cout << "PhysicsSystem: Registered " << colliderCount << " colliders with " << shapeCache.size() << " shapes" << std::endl;
+
+        // Remove the colliders of the entities that get removed from the world before the components delete their rigid bodies
+        if (this->world) this->world->removeRemovalListener(removalListener);
+        this->world = world;
+        removalListener = world->addRemovalListener([this](const std::vector<Entity*>& entities) {
+            std::vector<BulletColliderComponent*> removed;
+            for (Entity* entity : entities) {
+                if (auto* collider = entity->getComponent<BulletColliderComponent>()) removed.push_back(collider);
+            }
+            removeColliders(removed);
+        });
     }
 
     void PhysicsSystem::setGravity(const glm::vec3& gravityVec) {
@@ -135,6 +339,112 @@ namespace our {
         }
     }
 
+    namespace {
+        // Collects the distinct colliders touching the query object into a fixed number of slots
+        struct OverlapCallback : btCollisionWorld::ContactResultCallback {
+            const btCollisionObject* query;
+            BulletColliderComponent** results;
+            size_t capacity;
+            size_t count = 0;
+
+            OverlapCallback(const btCollisionObject* query, BulletColliderComponent** results, size_t capacity)
+                : query(query), results(results), capacity(capacity) {}
+
+            btScalar addSingleResult(btManifoldPoint&, const btCollisionObjectWrapper* first, int, int,
+                                     const btCollisionObjectWrapper* second, int, int) override {
+                const btCollisionObject* other = first->getCollisionObject() == query ? second->getCollisionObject() : first->getCollisionObject();
+                auto* collider = static_cast<BulletColliderComponent*>(other->getUserPointer());
+                if (!collider || count >= capacity || std::find(results, results + count, collider) != results + count) return 0;
+                results[count++] = collider;
+                return 0;
+            }
+        };
+
+        glm::vec3 toGlm(const btVector3& v) { return glm::vec3(v.x(), v.y(), v.z()); }
+        btVector3 toBullet(const glm::vec3& v) { return btVector3(v.x, v.y, v.z); }
+    }
+
+    void PhysicsSystem::runQueries(PhysicsQueryBatch& batch, bool parallel) {
+        size_t rayCount = batch.rays.size(), sweepCount = batch.sweeps.size(), overlapCount = batch.overlaps.size();
+        batch.rayHits.assign(rayCount, QueryHit());
+        batch.sweepHits.assign(sweepCount, QueryHit());
+        batch.overlapCounts.assign(overlapCount, 0);
+        batch.overlapResults.assign(overlapCount * batch.maxOverlapResults, nullptr);
+        if (!dynamicsWorld) return;
+
+        // The queries only filter by their own mask, so their group has all the bits
+        auto runRay = [&](size_t index) {
+            const auto& query = batch.rays[index];
+            btVector3 from = toBullet(query.from), to = toBullet(query.to);
+            btCollisionWorld::ClosestRayResultCallback callback(from, to);
+            callback.m_collisionFilterGroup = -1;
+            callback.m_collisionFilterMask = query.mask;
+            dynamicsWorld->rayTest(from, to, callback);
+            if (!callback.hasHit()) return;
+            QueryHit& hit = batch.rayHits[index];
+            hit.hit = true;
+            hit.fraction = callback.m_closestHitFraction;
+            hit.point = toGlm(callback.m_hitPointWorld);
+            hit.normal = toGlm(callback.m_hitNormalWorld);
+            hit.collider = static_cast<BulletColliderComponent*>(callback.m_collisionObject->getUserPointer());
+        };
+        auto runSweep = [&](size_t index) {
+            const auto& query = batch.sweeps[index];
+            btSphereShape sphere(query.radius);
+            btTransform from, to;
+            from.setIdentity();
+            to.setIdentity();
+            from.setOrigin(toBullet(query.from));
+            to.setOrigin(toBullet(query.to));
+            btCollisionWorld::ClosestConvexResultCallback callback(from.getOrigin(), to.getOrigin());
+            callback.m_collisionFilterGroup = -1;
+            callback.m_collisionFilterMask = query.mask;
+            dynamicsWorld->convexSweepTest(&sphere, from, to, callback);
+            if (!callback.hasHit() || !callback.m_hitCollisionObject) return;
+            QueryHit& hit = batch.sweepHits[index];
+            hit.hit = true;
+            hit.fraction = callback.m_closestHitFraction;
+            hit.point = toGlm(callback.m_hitPointWorld);
+            hit.normal = toGlm(callback.m_hitNormalWorld);
+            hit.collider = static_cast<BulletColliderComponent*>(callback.m_hitCollisionObject->getUserPointer());
+        };
+        auto runOverlap = [&](size_t index) {
+            const auto& query = batch.overlaps[index];
+            btSphereShape sphere(query.radius);
+            btCollisionObject object;
+            object.setCollisionShape(&sphere);
+            btTransform transform;
+            transform.setIdentity();
+            transform.setOrigin(toBullet(query.from));
+            object.setWorldTransform(transform);
+            OverlapCallback callback(&object, batch.overlapResults.data() + index * batch.maxOverlapResults, batch.maxOverlapResults);
+            callback.m_collisionFilterGroup = -1;
+            callback.m_collisionFilterMask = query.mask;
+            dynamicsWorld->contactTest(&object, callback);
+            batch.overlapCounts[index] = callback.count;
+        };
+
+        // Each query writes to its own result slots, so the queries can run in any order
+        // The rays and sweeps only read the broadphase and the shapes, so they run in parallel
+        auto run = [&](size_t first, size_t last) {
+            for (size_t index = first; index < last; ++index) {
+                if (index < rayCount) runRay(index);
+                else runSweep(index - rayCount);
+            }
+        };
+        size_t total = rayCount + sweepCount;
+        constexpr size_t GRAIN_SIZE = 16;
+        if (parallel && total > GRAIN_SIZE) {
+            ThreadPool::getShared().parallelFor(0, total, GRAIN_SIZE, run);
+        } else {
+            run(0, total);
+        }
+
+        // The overlaps run on this thread since "contactTest" creates and releases manifolds through the dispatcher,
+        // whose manifold array is not protected by a lock
+        for (size_t index = 0; index < overlapCount; ++index) runOverlap(index);
+    }
+
     bool PhysicsSystem::raycast(const glm::vec3& start, const glm::vec3& end,
                                 glm::vec3& hitPoint, glm::vec3& hitNormal,
                                 BulletColliderComponent** hitCollider) {
@@ -3,9 +3,32 @@
 #include <btBulletDynamicsCommon.h>
 #include "../ecs/world.hpp"
 #include "../components/bullet-collider.hpp"
+#include "collision-shape-cache.hpp"
+#include "bullet-task-scheduler.hpp"
+#include "physics-queries.hpp"
+
+#include <BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h>
+#include <memory>
+#include <utility>
 
 namespace our {
 
+    // A contact between two colliders reported by the physics system after a step
+    // Only the pairs where one of the colliders is a trigger or reports its contacts (see "BulletColliderComponent::reportContacts") are reported
+    struct CollisionEvent {
+        enum class Type {
+            BEGIN,  // The colliders started touching in this step
+            STAY,   // The colliders were already touching and still are
+            END     // The colliders stopped touching in this step
+        };
+        Type type;
+        BulletColliderComponent* first;
+        BulletColliderComponent* second;
+        bool trigger;                           // One of the colliders is a trigger
+        glm::vec3 point = glm::vec3(0.0f);      // The deepest contact point in world space (not set for END events)
+        glm::vec3 normal = glm::vec3(0.0f);     // The contact normal pointing from "second" to "first" (not set for END events)
+    };
+
     // This system manages the Bullet Physics simulation
     class PhysicsSystem {
     private:
@@ -15,33 +38,93 @@ namespace our {
         btBroadphaseInterface* overlappingPairCache;
         btSequentialImpulseConstraintSolver* solver;
         btDiscreteDynamicsWorld* dynamicsWorld;
+
+        // With multithreading, the islands are solved in parallel by a pool of solvers and
+        // the collision detection and the solvers run their loops on our thread pool through the task scheduler
+        bool multithreaded = false;
+        btConstraintSolverPoolMt* solverPool = nullptr;
+        std::unique_ptr<BulletTaskScheduler> taskScheduler;
         
         // Gravity
         btVector3 gravity;
+
+        // The simulation advances by fixed steps taken from the accumulated frame time
+        float fixedTimeStep = 1.0f / 60.0f;
+        int maxSubSteps = 4;            // The most steps taken in one frame (the rest of a long frame is dropped)
+        bool interpolate = true;        // Render the dynamic bodies between their last two steps
+        float accumulator = 0.0f;       // The frame time that was not simulated yet
         
         // Track initialized colliders
         std::vector<BulletColliderComponent*> colliders;
 
+        // The shapes shared by the colliders with the same configuration
+        CollisionShapeCache shapeCache;
+
+        // The collision events of the last call to "step" and the pairs that were touching after the last physics step
+        // The pairs are ordered by address (the first is the lower one) and the list is kept sorted to diff it against the next step
+        std::vector<CollisionEvent> events;
+        std::vector<std::pair<BulletColliderComponent*, BulletColliderComponent*>> touching;
+        std::vector<std::pair<BulletColliderComponent*, BulletColliderComponent*>> currentTouching;   // Reused by every step
+        std::vector<CollisionEvent> currentContacts;                                                // Reused by every step
+
+        // Read the contact manifolds of the dispatcher after a physics step and add its events
+        void collectEvents();
+        // Forget the touching pairs that include one of the given colliders (sorted), no END events are sent for them
+        void forgetContacts(const std::vector<BulletColliderComponent*>& sortedRemoved);
+
+        // The world whose colliders are registered and the id of our removal listener in it
+        World* world = nullptr;
+        size_t removalListener = 0;
+
     public:
         PhysicsSystem();
         ~PhysicsSystem();
 
-        // Initialize the physics world
-        void initialize(const glm::vec3& gravityVec = glm::vec3(0.0f, -9.81f, 0.0f));
+        // Initialize the physics world (a physics world created by an earlier call is destroyed first)
+        // The settings in the given config (see "configure") override the defaults
+        void initialize(const glm::vec3& gravityVec = glm::vec3(0.0f, -9.81f, 0.0f), const nlohmann::json& config = nlohmann::json::object());
+
+        // Destroy the physics world (the colliders keep their bodies since they own them)
+        void destroy();
+
+        // Read the physics settings from the scene config:
+        //      "physics": { "stepRate": 60, "maxSubSteps": 4, "interpolate": true, "gravity": [0, -9.8, 0], "multithreaded": true }
+        // "multithreaded" only takes effect when the physics world is created (in "initialize")
+        void configure(const nlohmann::json& config);
         
         // Register a collider with the physics world
         void registerCollider(BulletColliderComponent* collider);
         
         // Remove a collider from the physics world
         void removeCollider(BulletColliderComponent* collider);
+
+        // Remove a batch of colliders from the physics world in one sweep over the tracked colliders
+        void removeColliders(const std::vector<BulletColliderComponent*>& removed);
         
-        // Update physics simulation
+        // Update physics simulation (steps the simulation then syncs the dynamic bodies back to their entities)
         void update(float deltaTime);
+
+        // Step the simulation only (it doesn't touch the entities, so it can run while other systems move entities)
+        // The frame time is accumulated and the simulation takes as many fixed steps as fit in it (at most "maxSubSteps")
+        void step(float deltaTime);
+
+        // Sync the transforms of the dynamic bodies back to their entities
+        // With interpolation, the bodies are placed between their last two steps by the fraction of a step left in the accumulator
+        void syncToEntities();
+
+        // The fraction of a step between the last step and the current time (in [0, 1))
+        float getInterpolation() const { return interpolate ? accumulator / fixedTimeStep : 1.0f; }
+        float getFixedTimeStep() const { return fixedTimeStep; }
+
+        // The collision events of the physics steps taken by the last call to "step" in the order they happened
+        // The gameplay systems read them after the physics step instead of querying the contacts themselves
+        const std::vector<CollisionEvent>& getEvents() const { return events; }
         
         // Sync entity transforms to physics bodies (call before update)
         void syncFromEntities();
         
         // Find all colliders in the world and register them
+        // The colliders of the entities removed from the world later are removed from the physics world automatically
         void registerWorldColliders(World* world);
         
         // Set gravity
@@ -49,11 +132,20 @@ namespace our {
         
         // Get the dynamics world (for advanced usage)
         btDiscreteDynamicsWorld* getDynamicsWorld() { return dynamicsWorld; }
+
+        // Get the cache of the shapes shared by the colliders
+        CollisionShapeCache& getShapeCache() { return shapeCache; }
         
         // Raycast from start to end, returns true if hit
         bool raycast(const glm::vec3& start, const glm::vec3& end, 
                     glm::vec3& hitPoint, glm::vec3& hitNormal,
                     BulletColliderComponent** hitCollider = nullptr);
+
+        // Run all the queries of the batch and write their results in it
+        // The rays and sweeps only read the physics world, so they are spread over the thread pool if "parallel" is true.
+        // The overlaps go through the collision dispatcher (which is not thread safe), so they always run on the calling thread.
+        // The queries must not run while the simulation is stepping
+        void runQueries(PhysicsQueryBatch& batch, bool parallel = true);
     };
 
 }
@@ -0,0 +1,114 @@
+#include "system-scheduler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace our {
+
+    SystemScheduler::SystemBuilder SystemScheduler::add(const std::string& name, std::function<void(float)> run){
+        System system;
+        system.name = name;
+        system.run = std::move(run);
+        systems.push_back(std::move(system));
+        return SystemBuilder(systems.back());
+    }
+
+    void SystemScheduler::setEnabled(const std::string& name, bool enabled){
+        for(auto& system : systems){
+            if(system.name == name) system.enabled = enabled;
+        }
+    }
+
+    bool SystemScheduler::conflict(const System& first, const System& second){
+        if(first.exclusive || second.exclusive) return true;
+        auto contains = [](const std::vector<ComponentTypeID>& types, ComponentTypeID type){
+            return std::find(types.begin(), types.end(), type) != types.end();
+        };
+        for(ComponentTypeID type : first.writes){
+            if(contains(second.reads, type) || contains(second.writes, type)) return true;
+        }
+        for(ComponentTypeID type : second.writes){
+            if(contains(first.reads, type)) return true;
+        }
+        return false;
+    }
+
+    void SystemScheduler::run(float deltaTime){
+        using Clock = std::chrono::steady_clock;
+        auto frameStart = Clock::now();
+
+        // Build the dependency graph of the enabled systems: a system waits for every earlier system it conflicts with
+        std::vector<size_t> enabled;
+        for(size_t index = 0; index < systems.size(); ++index){
+            systems[index].time = 0.0f;
+            if(systems[index].enabled) enabled.push_back(index);
+        }
+        size_t count = enabled.size();
+        if(count == 0) return;
+        std::vector<std::vector<size_t>> successors(count);
+        std::unique_ptr<std::atomic<int>[]> waiting(new std::atomic<int>[count]);
+        for(size_t second = 0; second < count; ++second){
+            int dependencies = 0;
+            for(size_t first = 0; first < second; ++first){
+                if(conflict(systems[enabled[first]], systems[enabled[second]])){
+                    successors[first].push_back(second);
+                    ++dependencies;
+                }
+            }
+            waiting[second].store(dependencies);
+        }
+
+        // The ready systems that must run on this thread
+        std::mutex mainMutex;
+        std::vector<size_t> mainReady;
+        std::atomic<size_t> finished{0};
+
+        std::function<void(size_t)> launch;
+        auto execute = [&](size_t node){
+            System& system = systems[enabled[node]];
+            auto start = Clock::now();
+            system.run(deltaTime);
+            system.time = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+            for(size_t successor : successors[node]){
+                if(waiting[successor].fetch_sub(1) == 1) launch(successor);
+            }
+            finished.fetch_add(1);
+        };
+        launch = [&](size_t node){
+            if(systems[enabled[node]].mainThread){
+                std::lock_guard<std::mutex> lock(mainMutex);
+                mainReady.push_back(node);
+            } else {
+                pool->submit([&execute, node](){ execute(node); });
+            }
+        };
+
+        for(size_t node = 0; node < count; ++node){
+            if(waiting[node].load() == 0) launch(node);
+        }
+        // Run the main thread systems when they get ready and help the workers meanwhile
+        while(finished.load() < count){
+            size_t node = count;
+            {
+                std::lock_guard<std::mutex> lock(mainMutex);
+                if(!mainReady.empty()){
+                    node = mainReady.back();
+                    mainReady.pop_back();
+                }
+            }
+            if(node < count) execute(node);
+            else if(!pool->runPendingTask()) std::this_thread::yield();
+        }
+
+        for(size_t index : enabled){
+            System& system = systems[index];
+            system.averageTime = system.averageTime == 0.0f ? system.time : system.averageTime + smoothing * (system.time - system.averageTime);
+        }
+        frameTime = std::chrono::duration<float, std::milli>(Clock::now() - frameStart).count();
+    }
+
+}
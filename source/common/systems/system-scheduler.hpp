@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../ecs/component.hpp"
+#include "../threading/thread-pool.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace our {
+
+    // The system scheduler runs the systems of a state every frame, in parallel where it is safe.
+    // Each system declares the data types it reads and writes. These are usually component types, but any type can be used
+    // as a shared resource (e.g. "Transform" for the entity transforms). Two systems conflict if one of them writes a type that
+    // the other reads or writes, and conflicting systems run in the order they were added. Every frame, the scheduler builds the
+    // dependency graph of the enabled systems and runs each system on the thread pool as soon as the systems it depends on finish.
+    // Systems that must run on the main thread (e.g. the ones that use OpenGL or the input devices) are run by the calling thread.
+    class SystemScheduler {
+    public:
+        // The information and timings of a system
+        struct System {
+            std::string name;
+            std::function<void(float)> run;         // Called with the delta time
+            std::vector<ComponentTypeID> reads;
+            std::vector<ComponentTypeID> writes;
+            bool mainThread = false;                // Must run on the thread that calls "run"
+            bool exclusive = false;                 // Conflicts with every other system (e.g. it adds or removes entities)
+            bool enabled = true;
+            float time = 0.0f;                      // The time (in milliseconds) the system took in the last frame
+            float averageTime = 0.0f;               // The exponential moving average of the time
+        };
+
+        // Returned by "add" to declare the accesses of the new system
+        class SystemBuilder {
+            System& system;
+        public:
+            explicit SystemBuilder(System& system) : system(system) {}
+            template<typename... T> SystemBuilder& reads() { (system.reads.push_back(getComponentTypeID<T>()), ...); return *this; }
+            template<typename... T> SystemBuilder& writes() { (system.writes.push_back(getComponentTypeID<T>()), ...); return *this; }
+            SystemBuilder& onMainThread() { system.mainThread = true; return *this; }
+            SystemBuilder& exclusive() { system.exclusive = true; return *this; }
+        };
+
+        explicit SystemScheduler(ThreadPool* pool = &ThreadPool::getShared()) : pool(pool) {}
+
+        // Adds a system. The order of the systems is kept between conflicting systems.
+        //      scheduler.add("Movement", [&](float dt){ movementSystem.update(&world, dt); })
+        //          .reads<MovementComponent>().writes<Transform>();
+        SystemBuilder add(const std::string& name, std::function<void(float)> run);
+
+        // Enables or disables the system with the given name (disabled systems are skipped and don't block the others)
+        void setEnabled(const std::string& name, bool enabled);
+
+        // Runs all the enabled systems and returns when all of them finished
+        void run(float deltaTime);
+
+        // Removes all the systems
+        void clear() { systems.clear(); }
+
+        const std::vector<System>& getSystems() const { return systems; }
+        // The time (in milliseconds) taken by the last call to "run" (it is less than the sum of the system times if they overlapped)
+        float getFrameTime() const { return frameTime; }
+
+    private:
+        ThreadPool* pool;
+        std::vector<System> systems;
+        float frameTime = 0.0f;
+        float smoothing = 0.1f; // The weight of the newest time in the moving averages
+
+        static bool conflict(const System& first, const System& second);
+    };
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "../ecs/world.hpp"
+#include "../ecs/matrix-simd.hpp"
+#include "../threading/thread-pool.hpp"
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace our
+{
+
+    // The transform system keeps the cached local to world matrices of the entities up to date.
+    // When the local transform of an entity is edited (see Entity::editLocalTransform), the entity and its descendants are marked dirty
+    // and the entity is added to the dirty list of the world. Once per frame, this system recomputes the dirty entities only,
+    // each one once, with every parent computed before its children. The rest of the frame then reads the cached matrices.
+    // When many entities are dirty (e.g. crowds of animated characters), the hierarchy is flattened into breadth first levels
+    // and each level is computed in parallel on the shared thread pool, since the entities of a level only read the previous level.
+    class TransformSystem {
+        // The entities of the world grouped by their depth (level 0 holds the roots)
+        std::vector<std::vector<Entity*>> levels;
+        const World* levelsWorld = nullptr;
+        size_t levelsVersion = 0;
+
+        size_t parallelThreshold = 1024;    // The minimum number of dirty entities to use the parallel path
+        size_t grainSize = 128;             // The number of entities computed by each parallel task
+
+        // Computes the matrix of a dirty entity whose parent (if any) is up to date
+        static void updateEntity(Entity* entity) {
+            const Transform& local = entity->localTransform;
+            entity->localToWorld = entity->parent ? simd::multiplyAffine(entity->parent->localToWorld, local.toAffine()) : local.toMat4();
+            entity->transformDirty = false;
+        }
+
+        // Computes the matrix of the given entity then goes down to its dirty children
+        static void updateSubtree(Entity* entity) {
+            updateEntity(entity);
+            for(Entity* child : entity->children){
+                if(child->transformDirty) updateSubtree(child);
+            }
+        }
+
+        // Rebuilds the level arrays if the hierarchy changed since they were built
+        void rebuildLevels(World* world) {
+            if(levelsWorld == world && levelsVersion == world->hierarchyVersion) return;
+            levelsWorld = world;
+            levelsVersion = world->hierarchyVersion;
+            for(auto& level : levels) level.clear();
+            size_t depth = 0;
+            if(levels.empty()) levels.emplace_back();
+            for(Entity* entity : world->entities){
+                if(!entity->parent) levels[0].push_back(entity);
+            }
+            while(!levels[depth].empty()){
+                if(levels.size() <= depth + 1) levels.emplace_back();
+                for(Entity* entity : levels[depth]){
+                    levels[depth + 1].insert(levels[depth + 1].end(), entity->children.begin(), entity->children.end());
+                }
+                ++depth;
+            }
+        }
+
+        // Computes the dirty entities level by level, splitting each level across the thread pool
+        void updateParallel(World* world) {
+            rebuildLevels(world);
+            ThreadPool& pool = ThreadPool::getShared();
+            for(auto& level : levels){
+                if(level.empty()) break;
+                pool.parallelFor(0, level.size(), grainSize, [&level](size_t first, size_t last){
+                    for(size_t index = first; index < last; ++index){
+                        if(level[index]->transformDirty) updateEntity(level[index]);
+                    }
+                });
+            }
+        }
+
+    public:
+
+        // Sets the minimum number of dirty entities needed to update the matrices in parallel and the size of each parallel task
+        void setParallelOptions(size_t threshold, size_t grain) {
+            parallelThreshold = threshold;
+            grainSize = grain;
+        }
+
+        // This should be called every frame after the systems that move the entities and before the systems that read the matrices
+        void update(World* world) {
+            if(world->dirtyTransforms.empty()) return;
+            if(world->dirtyTransformCount >= parallelThreshold && ThreadPool::getShared().getWorkerCount() > 0){
+                updateParallel(world);
+            } else {
+                for(Entity* entity : world->dirtyTransforms){
+                    // The entity may have been updated already as a descendant of an earlier entry
+                    if(!entity->transformDirty) continue;
+                    // Start from the highest dirty ancestor so that every parent is computed before its children
+                    Entity* top = entity;
+                    while(top->parent && top->parent->transformDirty) top = top->parent;
+                    updateSubtree(top);
+                }
+            }
+            world->dirtyTransforms.clear();
+            world->dirtyTransformCount = 0;
+        }
+
+    };
+
+}
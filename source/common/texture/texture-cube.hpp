@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glad/gl.h>
+
+namespace our {
+
+    // This class defined an OpenGL texture which will be used as a GL_TEXTURE_CUBE_MAP
+    // A cube map holds 6 square faces and is sampled using a direction instead of texture coordinates (e.g. for skies)
+    class TextureCube {
+        // The OpenGL object name of this texture 
+        GLuint name = 0;
+    public:
+        // This constructor creates an OpenGL texture and saves its object name in the member variable "name" 
+        TextureCube() {
+            glGenTextures(1, &name);
+            // Bind and set some reasonable default parameters (clamping hides the seams between the faces)
+            glBindTexture(GL_TEXTURE_CUBE_MAP, name);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        }
+
+        // This deconstructor deletes the underlying OpenGL texture
+        ~TextureCube() {
+            if(name != 0) {
+                glDeleteTextures(1, &name);
+                name = 0;
+            }
+        }
+
+        // Get the internal OpenGL name of the texture
+        GLuint getOpenGLName() {
+            return name;
+        }
+
+        // This method binds this texture to GL_TEXTURE_CUBE_MAP
+        void bind() const {
+            glBindTexture(GL_TEXTURE_CUBE_MAP, name);
+        }
+
+        // This static method ensures that no texture is bound to GL_TEXTURE_CUBE_MAP
+        static void unbind(){
+            glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        }
+
+        TextureCube(const TextureCube&) = delete;
+        TextureCube& operator=(const TextureCube&) = delete;
+    };
+
+}
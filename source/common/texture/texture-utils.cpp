@@ -20,6 +20,14 @@ our::Texture2D* our::texture_utils::empty(GLenum format, glm::ivec2 size){
         externalFormat = GL_DEPTH_COMPONENT;
         externalType = GL_UNSIGNED_INT;
     }
+    // Single channel formats (e.g. the OIT weights) use the red external format
+    if(format == GL_R8 || format == GL_R16F || format == GL_R32F){
+        externalFormat = GL_RED;
+    }
+    // Floating point formats (e.g. the OIT accumulation target) use the float type
+    if(format == GL_R16F || format == GL_R32F || format == GL_RGBA16F || format == GL_RGBA32F){
+        externalType = GL_FLOAT;
+    }
     glTexImage2D(GL_TEXTURE_2D, 0, format, size.x, size.y, 0, externalFormat, externalType, nullptr);
     // Set reasonable parameters for framebuffer textures (no interpolation)
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -71,4 +79,26 @@ our::Texture2D* our::texture_utils::loadImage(const std::string& filename, bool
     
     stbi_image_free(pixels); //Free image data after uploading to GPU
     return texture;
+}
+
+our::TextureCube* our::texture_utils::loadCubemap(const std::array<std::string, 6>& filenames) {
+    // Unlike 2D textures, the cube map faces are defined with their origin at the top left so we don't flip them
+    stbi_set_flip_vertically_on_load(false);
+    our::TextureCube* texture = new our::TextureCube();
+    texture->bind();
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for(size_t face = 0; face < filenames.size(); ++face){
+        glm::ivec2 size;
+        int channels;
+        unsigned char* pixels = stbi_load(filenames[face].c_str(), &size.x, &size.y, &channels, 4);
+        if(pixels == nullptr){
+            std::cerr << "Failed to load image: " << filenames[face] << std::endl;
+            continue;
+        }
+        // The cube map face targets are consecutive, starting from +X
+        glTexImage2D(GLenum(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face), 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+        stbi_image_free(pixels);
+    }
+    our::TextureCube::unbind();
+    return texture;
 }
\ No newline at end of file
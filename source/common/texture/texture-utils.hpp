@@ -1,6 +1,8 @@
 #pragma once
 
 #include "texture2d.hpp"
+#include "texture-cube.hpp"
+#include <array>
 #include <string>
 
 #include <glad/gl.h>
@@ -11,4 +13,7 @@ namespace our::texture_utils {
     Texture2D* empty(GLenum format, glm::ivec2 size);
     // This function loads an image and sends its data to the given Texture2D 
     Texture2D* loadImage(const std::string& filename, bool generate_mipmap = true);
+    // This function loads 6 images into the faces of a cube map
+    // The files must be given in the order: +X, -X, +Y, -Y, +Z, -Z
+    TextureCube* loadCubemap(const std::array<std::string, 6>& filenames);
 }
\ No newline at end of file
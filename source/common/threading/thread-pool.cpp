@@ -0,0 +1,102 @@
+#include "thread-pool.hpp"
+
+#include <algorithm>
+#include <memory>
+
+namespace our {
+
+    ThreadPool::ThreadPool(size_t workerCount){
+        workers.reserve(workerCount);
+        for(size_t index = 0; index < workerCount; ++index){
+            workers.emplace_back([this](){ workerLoop(); });
+        }
+    }
+
+    ThreadPool::~ThreadPool(){
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeUp.notify_all();
+        for(auto& worker : workers) worker.join();
+    }
+
+    ThreadPool& ThreadPool::getShared(){
+        static ThreadPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+        return pool;
+    }
+
+    void ThreadPool::workerLoop(){
+        while(true){
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [this](){ return stopping || !tasks.empty(); });
+                if(tasks.empty()) return; // We only stop after the queue is drained
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    void ThreadPool::submit(std::function<void()> task){
+        if(workers.empty()){
+            task();
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+        }
+        wakeUp.notify_one();
+    }
+
+    bool ThreadPool::runPendingTask(){
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if(tasks.empty()) return false;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+        return true;
+    }
+
+    void ThreadPool::parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body){
+        if(begin >= end) return;
+        grainSize = std::max<size_t>(grainSize, 1);
+        size_t rangeCount = (end - begin + grainSize - 1) / grainSize;
+        if(workers.empty() || rangeCount == 1){
+            body(begin, end);
+            return;
+        }
+
+        // The ranges are claimed from a shared counter by the calling thread and by helper tasks on the workers.
+        // The state is shared since a helper may start after the call returned (when the other threads took all the ranges).
+        struct State {
+            std::atomic<size_t> nextRange{0};
+            std::atomic<size_t> finishedRanges{0};
+        };
+        auto state = std::make_shared<State>();
+        auto work = [state, begin, end, grainSize, rangeCount, &body](){
+            size_t range;
+            while((range = state->nextRange.fetch_add(1)) < rangeCount){
+                size_t first = begin + range * grainSize;
+                body(first, std::min(first + grainSize, end));
+                state->finishedRanges.fetch_add(1, std::memory_order_release);
+            }
+        };
+        // Note: a late helper never calls "body" (all the ranges are claimed), so capturing it by reference is safe
+        size_t helperCount = std::min(workers.size(), rangeCount - 1);
+        for(size_t index = 0; index < helperCount; ++index) submit(work);
+        work();
+
+        // Wait for the ranges taken by the workers, running other queued tasks meanwhile
+        while(state->finishedRanges.load(std::memory_order_acquire) < rangeCount){
+            if(!runPendingTask()) std::this_thread::yield();
+        }
+    }
+
+}
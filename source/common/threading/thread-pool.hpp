@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace our {
+
+    // A fixed set of worker threads that run tasks from a shared queue.
+    // The thread that waits for work (for example, the caller of "parallelFor") runs queued tasks while it waits,
+    // so the pool can be used from inside its own tasks without running out of threads.
+    class ThreadPool {
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        bool stopping = false;
+
+        void workerLoop();
+    public:
+        // Creates a pool with the given number of worker threads
+        // If the count is 0, every task runs on the thread that submits or waits for it
+        explicit ThreadPool(size_t workerCount);
+        ~ThreadPool();
+
+        // Returns the pool shared by the engine systems. It has one worker less than the hardware threads
+        // since the main thread works too while it waits.
+        static ThreadPool& getShared();
+
+        // The number of worker threads (not counting the waiting thread)
+        size_t getWorkerCount() const { return workers.size(); }
+
+        // Adds a task to the queue. If the pool has no workers, the task runs immediately.
+        void submit(std::function<void()> task);
+
+        // Runs one queued task on the calling thread. Returns false if the queue was empty.
+        bool runPendingTask();
+
+        // Calls "body(first, last)" over [begin, end) split into ranges of "grainSize" items and returns once all of them finished.
+        // The ranges run in parallel on the workers and the calling thread.
+        void parallelFor(size_t begin, size_t end, size_t grainSize, const std::function<void(size_t, size_t)>& body);
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+    };
+
+}
@@ -6,9 +6,13 @@
 #include <systems/forward-renderer.hpp>
 #include <systems/free-camera-controller.hpp>
 #include <systems/movement.hpp>
+#include <systems/transform-system.hpp>
 #include <systems/physics-system.hpp>
+#include <systems/system-scheduler.hpp>
 #include <asset-loader.hpp>
 
+#include <imgui.h>
+
 // This state shows how to use the ECS framework and deserialization.
 class Playstate: public our::State {
 
@@ -16,8 +20,11 @@ class Playstate: public our::State {
     our::ForwardRenderer renderer;
     our::FreeCameraControllerSystem cameraController;
     our::MovementSystem movementSystem;
+    our::TransformSystem transformSystem;
     our::PhysicsSystem physicsSystem;
+    our::SystemScheduler scheduler;
     bool first_frame = true;  // Instance variable to track first frame
+    bool showProfiler = false; // Toggled with F3 to show the renderer counters
 
     void onInitialize() override {
         // First of all, we get the scene configuration from the app config
@@ -33,31 +40,46 @@ class Playstate: public our::State {
         // We initialize the camera controller system since it needs a pointer to the app
         cameraController.enter(getApp());
         // Initialize physics system with gravity
-        physicsSystem.initialize(glm::vec3(0.0f, -9.8f, 0.0f));
+        // (the physics settings of the scene config override the defaults)
+        physicsSystem.initialize(glm::vec3(0.0f, -9.8f, 0.0f), config.value("physics", nlohmann::json::object()));
         physicsSystem.registerWorldColliders(&world);
         // Then we initialize the renderer
         auto size = getApp()->getFrameBufferSize();
         renderer.initialize(size, config["renderer"]);
+
+        // Finally, we add the systems to the scheduler in the order they should run.
+        // Systems that don't share any written data (e.g. the physics step and the movement system) run in parallel.
+        // The "Transform" type stands for the entity transforms (and the world's dirty list that is filled while editing them).
+        scheduler.clear();
+        scheduler.add("Player Input", [this](float){ updatePlayer(); })
+            .onMainThread().reads<our::CameraComponent>().writes<our::BulletColliderComponent, our::Transform>();
+        scheduler.add("Physics Step", [this](float deltaTime){ physicsSystem.step(deltaTime); })
+            .writes<our::BulletColliderComponent>();
+        scheduler.add("Movement", [this](float deltaTime){ movementSystem.update(&world, deltaTime); })
+            .reads<our::MovementComponent>().writes<our::Transform>();
+        // The camera controller is not added since we handle the player movement with physics
+        scheduler.add("Physics Sync", [this](float){ physicsSystem.syncToEntities(); })
+            .reads<our::BulletColliderComponent>().writes<our::Transform>();
+        // Delete the entities that were marked for removal this frame (the physics system is notified first)
+        scheduler.add("Entity Removal", [this](float){ world.deleteMarkedEntities(); })
+            .exclusive();
+        // Recompute the world matrices of the entities that moved this frame
+        scheduler.add("Transforms", [this](float){ transformSystem.update(&world); })
+            .writes<our::Transform>();
+        // The renderer keeps the level of detail picked for each mesh renderer in the component, so it writes them
+        scheduler.add("Render", [this](float){ renderer.render(&world); })
+            .onMainThread().reads<our::Transform, our::CameraComponent>().writes<our::MeshRendererComponent>();
     }
 
-    void onDraw(double deltaTime) override {
-        // Handle mouse rotation and keyboard movement for camera
+    // Rotates the player with the mouse and sets its velocity from the keyboard
+    void updatePlayer() {
         auto& mouse = getApp()->getMouse();
         auto& kb = getApp()->getKeyboard();
         
-        // Lock mouse on startup
-        static bool mouse_locked = false;
-        if(!mouse_locked){
-            mouse.lockMouse(getApp()->getWindow());
-            mouse_locked = true;
-            first_frame = true;  // Reset first_frame when entering play state
-        }
-        
-        for(auto entity : world.getEntities()){
-            auto* collider = entity->getComponent<our::BulletColliderComponent>();
-            auto* camera = entity->getComponent<our::CameraComponent>();
-            // Only apply mouse rotation to entities with a camera
-            if(collider && collider->mass > 0.0f && collider->rigidBody && camera) {
+        // Only apply mouse rotation to entities with a camera
+        world.view<our::CameraComponent, our::BulletColliderComponent>().forEach(
+            [&](our::Entity* entity, our::CameraComponent*, our::BulletColliderComponent* collider){
+            if(collider->mass > 0.0f && collider->rigidBody) {
                 // Handle mouse rotation (always active now)
                 glm::vec2 delta = mouse.getMouseDelta();
                 // Skip the first frame to ignore initial mouse position
@@ -65,21 +87,21 @@ class Playstate: public our::State {
                     delta = glm::vec2(0.0f);
                     first_frame = false;
                 }
-                glm::vec3 rotation = entity->localTransform.rotation;
+                glm::vec3 rotation = entity->getLocalTransform().getEulerRotation();
                 rotation.x -= delta.y * 0.01f;
                 rotation.y -= delta.x * 0.01f;
                 // Clamp pitch to prevent flipping
                 if(rotation.x < -glm::half_pi<float>() * 0.99f) rotation.x = -glm::half_pi<float>() * 0.99f;
                 if(rotation.x > glm::half_pi<float>() * 0.99f) rotation.x = glm::half_pi<float>() * 0.99f;
-                entity->localTransform.rotation = rotation;
+                entity->editLocalTransform().setEulerRotation(rotation);
                 
                 glm::vec3 velocity(0, 0, 0);
                 float speed = 5.0f;
                 
                 // Get camera direction
-                glm::mat4 matrix = entity->localTransform.toMat4();
-                glm::vec3 forward = glm::vec3(matrix * glm::vec4(0, 0, -1, 0));
-                glm::vec3 right = glm::vec3(matrix * glm::vec4(1, 0, 0, 0));
+                const our::Transform& transform = entity->getLocalTransform();
+                glm::vec3 forward = transform.getForward();
+                glm::vec3 right = transform.getRight();
                 
                 // WASD movement
                 if(kb.isPressed(GLFW_KEY_W)) velocity += forward * speed;
@@ -91,35 +113,66 @@ class Playstate: public our::State {
                 collider->rigidBody->setLinearVelocity(btVector3(velocity.x, collider->rigidBody->getLinearVelocity().y(), velocity.z));
                 collider->rigidBody->activate();
             }
+        });
+    }
+
+    void onDraw(double deltaTime) override {
+        // Lock mouse on startup
+        static bool mouse_locked = false;
+        if(!mouse_locked){
+            getApp()->getMouse().lockMouse(getApp()->getWindow());
+            mouse_locked = true;
+            first_frame = true;  // Reset first_frame when entering play state
         }
-        
-        // Update physics simulation (this applies collision response)
-        physicsSystem.update((float)deltaTime);
-        
-        // Sync physics results BACK to entities
-        for(auto entity : world.getEntities()){
-            auto* collider = entity->getComponent<our::BulletColliderComponent>();
-            if(collider && collider->mass > 0.0f) {
-                collider->syncToEntity(); // Update entity from physics
-            }
-        }
-        
-        // Run other systems (but NOT camera controller - we handle movement with physics)
-        movementSystem.update(&world, (float)deltaTime);
-        // cameraController.update(&world, (float)deltaTime); // DISABLED
-        
-        // And finally we use the renderer system to draw the scene
-        renderer.render(&world);
+
+        // Run all the systems (input, physics, movement, transforms and rendering)
+        scheduler.run((float)deltaTime);
 
         // Get a reference to the keyboard object
         auto& keyboard = getApp()->getKeyboard();
 
+        if(keyboard.justPressed(GLFW_KEY_F3)){
+            showProfiler = !showProfiler;
+        }
+
         if(keyboard.justPressed(GLFW_KEY_ESCAPE)){
             // If the escape  key is pressed in this frame, go to the play state
             getApp()->changeState("menu");
         }
     }
 
+    void onImmediateGui() override {
+        if(!showProfiler) return;
+        const auto& stats = renderer.getStats();
+        const auto& dynamicResolution = renderer.getDynamicResolution();
+
+        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_FirstUseEver);
+        ImGui::Begin("Profiler", &showProfiler, ImGuiWindowFlags_AlwaysAutoResize);
+        float framerate = ImGui::GetIO().Framerate;
+        ImGui::Text("Frame: %.2f ms (%.0f FPS)", 1000.0f / framerate, framerate);
+        if(dynamicResolution.isEnabled()){
+            ImGui::Text("GPU: %.2f ms at %.0f%% resolution", dynamicResolution.getGpuFrameTime(), dynamicResolution.getScale() * 100.0f);
+        }
+        ImGui::Separator();
+        ImGui::Text("Draws: %d opaque, %d transparent", stats.opaqueCommands, stats.transparentCommands);
+        for(int level = 0; level < our::RenderStats::LOD_LEVELS; ++level){
+            if(stats.lodCommands[level] == 0) continue;
+            ImGui::Text("LOD %d%s: %d draws, %d triangles", level, level == our::RenderStats::LOD_LEVELS - 1 ? "+" : "",
+                stats.lodCommands[level], stats.lodTriangles[level]);
+        }
+        if(stats.occlusionTested > 0){
+            ImGui::Text("Occlusion culling: %d / %d culled (%.1f%%)", stats.occlusionCulled, stats.occlusionTested,
+                100.0f * stats.occlusionCulled / stats.occlusionTested);
+        }
+        ImGui::Separator();
+        ImGui::Text("Systems: %.2f ms", scheduler.getFrameTime());
+        for(const auto& system : scheduler.getSystems()){
+            ImGui::Text("  %-16s %6.2f ms (avg %.2f)%s", system.name.c_str(), system.time, system.averageTime,
+                system.mainThread ? " [main]" : "");
+        }
+        ImGui::End();
+    }
+
     void onDestroy() override {
         // Don't forget to destroy the renderer
         renderer.destroy();